@@ -16,7 +16,13 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include "floyd.h"
+#include <unistd.h>
+
+#define FLOYD_CHECKPOINT_MAGIC "FLOYDCK1"
+#define FLOYD_CHECKPOINT_MAGIC_SIZE 8
 
 floyd_context* floyd_context_new(int nodes)
 {
@@ -60,6 +66,10 @@ floyd_context* floyd_context_new(int nodes)
     }
 
     c->nodes = nodes;
+    c->checkpoint_file = NULL;
+    c->checkpoint_interval = 0;
+    c->processes = 1;
+    c->log_iterations = true;
 
     c->status = -1;
     c->execution_time = 0.0;
@@ -88,21 +98,30 @@ void floyd_context_free(floyd_context* c)
     return;
 }
 
-bool floyd(floyd_context *c)
+/* Tell if the tables of every iteration are logged, see floyd() */
+static bool floyd_logging(floyd_context* c)
 {
-    /* Create graph and first iteration */
-    floyd_graph(c->table_d, c->names);
-    floyd_execution(c, 0);
+    bool checkpoints = (c->checkpoint_file != NULL) &&
+                       (c->checkpoint_interval > 0);
+    return c->log_iterations && !checkpoints &&
+           (c->nodes <= FLOYD_LOG_MAX_NODES);
+}
 
-    /* Start counting time */
-    GTimer* timer = g_timer_new();
+/* Log the final tables if the iterations weren't */
+static void floyd_log_final(floyd_context* c)
+{
+    if(c->nodes <= FLOYD_LOG_MAX_NODES) {
+        floyd_execution(c, c->nodes);
+    }
+}
 
-    /* Run the Floyd Warshall algorithm */
+static void floyd_iterate(floyd_context* c, int from, bool log)
+{
     matrix* d = c->table_d;
     matrix* p = c->table_p;
     int nodes = d->rows;
 
-    for(int k = 0; k < nodes; k++) {
+    for(int k = from; k < nodes; k++) {
         for(int i = 0; i < nodes; i++) {
             for(int j = 0; j < nodes; j++) {
                 float minimum = fminf(d->data[i][j],
@@ -114,12 +133,257 @@ bool floyd(floyd_context *c)
             }
         }
         /* Log execution */
-        floyd_execution(c, k + 1);
+        if(log) {
+            floyd_execution(c, k + 1);
+        }
+
+        /* Save progress */
+        if((c->checkpoint_file != NULL) && (c->checkpoint_interval > 0) &&
+           (((k + 1) % c->checkpoint_interval == 0) || (k + 1 == nodes))) {
+            if(!floyd_checkpoint(c, k + 1)) {
+                c->status = FLOYD_CHECKPOINT_FAILED;
+            }
+        }
+    }
+}
+
+/* Run the algorithm on the tables as they are, from the first iteration */
+static bool floyd_solve(floyd_context* c)
+{
+    /* First iteration */
+    c->status = FLOYD_SUCCESS;
+    bool log = floyd_logging(c);
+    if(log) {
+        floyd_execution(c, 0);
+    }
+
+    /* Start counting time */
+    GTimer* timer = g_timer_new();
+
+    /* Run the Floyd Warshall algorithm */
+    bool success = true;
+    if(c->processes > 1) {
+        success = floyd_processes(c, c->processes);
+        floyd_log_final(c);
+    } else {
+        floyd_iterate(c, 0, log);
+        if(!log) {
+            floyd_log_final(c);
+        }
     }
 
+    /* Stop counting time */
+    g_timer_stop(timer);
+    c->execution_time = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+    return success;
+}
+
+bool floyd(floyd_context *c)
+{
+    /* Create graph */
+    if(c->nodes <= FLOYD_GRAPH_MAX_NODES) {
+        floyd_graph(c->table_d, c->names);
+    }
+    return floyd_solve(c);
+}
+
+bool floyd_resume(floyd_context *c)
+{
+    /* Create graph, the checkpoint replaces the input */
+    if(c->nodes <= FLOYD_GRAPH_MAX_NODES) {
+        floyd_graph(c->table_d, c->names);
+    }
+
+    /* Restore last checkpoint, if any */
+    int from = floyd_checkpoint_load(c);
+    if(from < 0) {
+        return floyd_solve(c);
+    }
+    fprintf(c->report_buffer, "Resumed at iteration %i from a checkpoint, "
+                              "the iterations before it were run by an "
+                              "earlier execution.\n\n", from);
+
+    /* Start counting time */
+    c->status = FLOYD_SUCCESS;
+    GTimer* timer = g_timer_new();
+
+    /* Continue the Floyd Warshall algorithm */
+    floyd_iterate(c, from, false);
+    floyd_log_final(c);
+
     /* Stop counting time */
     g_timer_stop(timer);
     c->execution_time = g_timer_elapsed(timer, NULL);
     g_timer_destroy(timer);
     return true;
 }
+
+float floyd_distance(floyd_context* c, int from, int to)
+{
+    return c->table_d->data[from][to];
+}
+
+static int floyd_subpath(matrix* p, int from, int to, int* path, int n)
+{
+    int k = (int)p->data[from][to];
+    if(k == 0) {
+        path[n] = to;
+        return n + 1;
+    }
+    n = floyd_subpath(p, from, k - 1, path, n);
+    return floyd_subpath(p, k - 1, to, path, n);
+}
+
+int floyd_path(floyd_context* c, int from, int to, int* path)
+{
+    if(c->table_d->data[from][to] == PLUS_INF) {
+        return 0;
+    }
+
+    path[0] = from;
+    if(from == to) {
+        return 1;
+    }
+    return floyd_subpath(c->table_p, from, to, path, 1);
+}
+
+/* FNV-1a, used to detect torn or corrupted checkpoint files */
+static unsigned int floyd_hash(unsigned int hash, void* data, size_t size)
+{
+    unsigned char* bytes = (unsigned char*) data;
+    for(size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+bool floyd_checkpoint(floyd_context* c, int k)
+{
+    if(c->checkpoint_file == NULL) {
+        return false;
+    }
+
+    /* Write to a temporary file, the last checkpoint stays valid meanwhile */
+    char* tmp_file = g_strdup_printf("%s.tmp", c->checkpoint_file);
+    FILE* f = fopen(tmp_file, "wb");
+    if(f == NULL) {
+        g_free(tmp_file);
+        return false;
+    }
+
+    bool success = true;
+    unsigned int hash = 2166136261u;
+    int nodes = c->nodes;
+    size_t row_size = nodes * sizeof(MATRIX_DATATYPE);
+
+    /* Header */
+    success &= fwrite(FLOYD_CHECKPOINT_MAGIC, 1,
+                      FLOYD_CHECKPOINT_MAGIC_SIZE, f) ==
+               FLOYD_CHECKPOINT_MAGIC_SIZE;
+    success &= fwrite(&nodes, sizeof(int), 1, f) == 1;
+    success &= fwrite(&k, sizeof(int), 1, f) == 1;
+    hash = floyd_hash(hash, &nodes, sizeof(int));
+    hash = floyd_hash(hash, &k, sizeof(int));
+
+    /* Tables */
+    matrix* tables[] = {c->table_d, c->table_p};
+    for(int t = 0; (t < 2) && success; t++) {
+        for(int i = 0; (i < nodes) && success; i++) {
+            success &= fwrite(tables[t]->data[i], row_size, 1, f) == 1;
+            hash = floyd_hash(hash, tables[t]->data[i], row_size);
+        }
+    }
+    success &= fwrite(&hash, sizeof(unsigned int), 1, f) == 1;
+
+    /* Make sure data reached the disk before replacing the checkpoint */
+    success &= fflush(f) == 0;
+    success &= fsync(fileno(f)) == 0;
+    success &= fclose(f) == 0;
+    if(success) {
+        success = rename(tmp_file, c->checkpoint_file) == 0;
+    }
+    if(!success) {
+        remove(tmp_file);
+    }
+
+    g_free(tmp_file);
+    return success;
+}
+
+/* Read a checkpoint into 'buffer', D rows then P rows, verifying its hash */
+static bool floyd_checkpoint_read(floyd_context* c, FILE* f,
+                                  MATRIX_DATATYPE* buffer, int* k)
+{
+    char magic[FLOYD_CHECKPOINT_MAGIC_SIZE];
+    int nodes = 0;
+    unsigned int hash = 2166136261u;
+    unsigned int expected = 0;
+
+    /* Header */
+    if((fread(magic, 1, FLOYD_CHECKPOINT_MAGIC_SIZE, f) !=
+            FLOYD_CHECKPOINT_MAGIC_SIZE) ||
+       (memcmp(magic, FLOYD_CHECKPOINT_MAGIC,
+               FLOYD_CHECKPOINT_MAGIC_SIZE) != 0) ||
+       (fread(&nodes, sizeof(int), 1, f) != 1) ||
+       (fread(k, sizeof(int), 1, f) != 1)) {
+        return false;
+    }
+    if((nodes != c->nodes) || (*k < 0) || (*k > nodes)) {
+        return false;
+    }
+    hash = floyd_hash(hash, &nodes, sizeof(int));
+    hash = floyd_hash(hash, k, sizeof(int));
+
+    /* Tables, hashed row by row as they were written */
+    size_t row_size = nodes * sizeof(MATRIX_DATATYPE);
+    for(int i = 0; i < 2 * nodes; i++) {
+        MATRIX_DATATYPE* row = buffer + (size_t)i * nodes;
+        if(fread(row, row_size, 1, f) != 1) {
+            return false;
+        }
+        hash = floyd_hash(hash, row, row_size);
+    }
+
+    if(fread(&expected, sizeof(unsigned int), 1, f) != 1) {
+        return false;
+    }
+    return hash == expected;
+}
+
+int floyd_checkpoint_load(floyd_context* c)
+{
+    if((c->checkpoint_file == NULL) || !file_exists(c->checkpoint_file)) {
+        return -1;
+    }
+
+    FILE* f = fopen(c->checkpoint_file, "rb");
+    if(f == NULL) {
+        return -1;
+    }
+
+    /* Read and verify the whole file before touching the tables */
+    size_t row_size = c->nodes * sizeof(MATRIX_DATATYPE);
+    MATRIX_DATATYPE* buffer = (MATRIX_DATATYPE*) malloc(2 * c->nodes *
+                                                        row_size);
+    int k = -1;
+    bool success = (buffer != NULL) &&
+                   floyd_checkpoint_read(c, f, buffer, &k);
+    fclose(f);
+
+    if(success) {
+        for(int i = 0; i < c->nodes; i++) {
+            memcpy(c->table_d->data[i], buffer + (size_t)i * c->nodes,
+                   row_size);
+            memcpy(c->table_p->data[i],
+                   buffer + (size_t)(c->nodes + i) * c->nodes, row_size);
+        }
+    }
+    free(buffer);
+
+    if(!success) {
+        return -1;
+    }
+    return k;
+}
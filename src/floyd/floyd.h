@@ -22,6 +22,18 @@
 #include "utils.h"
 #include "matrix.h"
 
+/* Largest graph whose tables are logged for the report, 150 nodes already
+ * take pages of LaTeX per iteration */
+#define FLOYD_LOG_MAX_NODES 150
+
+/* Largest graph drawn for the report, Graphviz takes too long beyond it */
+#define FLOYD_GRAPH_MAX_NODES 150
+
+/* Values of 'status' after an execution */
+#define FLOYD_SUCCESS 0
+#define FLOYD_CHECKPOINT_FAILED 1
+#define FLOYD_OUT_OF_MEMORY 2
+
 /**
  * Floyd's algorithm context data structure.
  */
@@ -40,6 +52,17 @@ typedef struct {
     char** names;
     int nodes;
 
+    /* Worker processes, see processes.h */
+    int processes;
+
+    /* Checkpointing */
+    char* checkpoint_file;
+    int checkpoint_interval;
+
+    /* Log the tables of every iteration for the report, on by default. See
+     * floyd() for when they are logged anyway */
+    bool log_iterations;
+
 } floyd_context;
 
 floyd_context* floyd_context_new(int nodes);
@@ -48,12 +71,88 @@ void floyd_context_free(floyd_context* c);
 /**
  * Perform Floyd algorithm with given context.
  *
+ * If 'processes' is greater than one the work is split between that many
+ * processes. Checkpoints and the per iteration log are only available when
+ * running in a single process.
+ *
+ * The tables of every iteration are logged for the report only with
+ * 'log_iterations' set, no checkpoints and at most FLOYD_LOG_MAX_NODES nodes,
+ * as they take longer to format than to compute. Otherwise only the final
+ * tables are logged, and none above FLOYD_LOG_MAX_NODES nodes. The graph is
+ * only drawn up to FLOYD_GRAPH_MAX_NODES nodes.
+ *
+ * A checkpoint that can't be written doesn't stop the execution, 'status' is
+ * set to FLOYD_CHECKPOINT_FAILED instead of FLOYD_SUCCESS.
+ *
  * @param floyd_context, the floyd's context data structure.
  * @return TRUE if execution was successful or FALSE if and error ocurred. Check
  *         'status' flag in context to know what went wrong.
  */
 bool floyd(floyd_context* c);
 
+/**
+ * Shortest distance between two nodes after a successful execution.
+ *
+ * @param floyd_context, the floyd's context data structure.
+ * @param from, the 0-based index of the source node.
+ * @param to, the 0-based index of the destination node.
+ * @return the distance, or PLUS_INF if the destination can't be reached.
+ */
+float floyd_distance(floyd_context* c, int from, int to);
+
+/**
+ * Reconstruct the shortest path between two nodes after a successful
+ * execution.
+ *
+ * @param floyd_context, the floyd's context data structure.
+ * @param from, the 0-based index of the source node.
+ * @param to, the 0-based index of the destination node.
+ * @param path, array of at least 'nodes' elements where the 0-based indexes
+ *        of the nodes in the path are stored, both ends included.
+ * @return the number of nodes in the path or 0 if the destination can't be
+ *         reached.
+ */
+int floyd_path(floyd_context* c, int from, int to, int* path);
+
+/**
+ * Write the current state of the algorithm to the context checkpoint file.
+ *
+ * The file is written to a temporary file first and then renamed over the
+ * previous checkpoint, so a crash while writing never destroys the last good
+ * checkpoint.
+ *
+ * @param floyd_context, the floyd's context data structure.
+ * @param k, the number of iterations already completed.
+ * @return TRUE if the checkpoint was written or FALSE otherwise.
+ */
+bool floyd_checkpoint(floyd_context* c, int k);
+
+/**
+ * Load the context checkpoint file into the D and P tables.
+ *
+ * @param floyd_context, the floyd's context data structure.
+ * @return the number of iterations completed when the checkpoint was written,
+ *         or -1 if the file is missing, corrupted or doesn't match the context.
+ *         On error the tables are left untouched.
+ */
+int floyd_checkpoint_load(floyd_context* c);
+
+/**
+ * Continue Floyd algorithm from the last checkpoint of the context.
+ *
+ * If no valid checkpoint is available the algorithm starts from the
+ * beginning, exactly as floyd() would. Otherwise the report notes the
+ * iteration it was resumed at, and only has the final tables.
+ *
+ * @param floyd_context, the floyd's context data structure.
+ * @return TRUE if execution was successful or FALSE if and error ocurred. Check
+ *         'status' flag in context to know what went wrong.
+ */
+bool floyd_resume(floyd_context* c);
+
 #include "report.h"
+#include "lazy.h"
+#include "hops.h"
+#include "processes.h"
 
 #endif
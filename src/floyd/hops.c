@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hops.h"
+
+floyd_hops_context* floyd_hops_context_new(floyd_context* c, int hops)
+{
+    /* Check input is correct */
+    if(hops < 1) {
+        return NULL;
+    }
+
+    /* Allocate structure */
+    floyd_hops_context* h = (floyd_hops_context*)
+                                calloc(1, sizeof(floyd_hops_context));
+    if(h == NULL) {
+        return NULL;
+    }
+
+    /* Try to allocate matrices */
+    h->table_a = matrix_new(c->nodes, c->nodes, PLUS_INF);
+    h->table_d = matrix_new(c->nodes, c->nodes, PLUS_INF);
+    if((h->table_a == NULL) || (h->table_d == NULL)) {
+        floyd_hops_context_free(h);
+        return NULL;
+    }
+
+    /* Copy adjacency, staying put is always possible */
+    matrix_copy(c->table_d, h->table_a);
+    for(int i = 0; i < c->nodes; i++) {
+        h->table_a->data[i][i] = 0.0;
+    }
+
+    h->nodes = c->nodes;
+    h->hops = hops;
+    h->result = HOPS_ADJACENCY;
+
+    h->status = -1;
+    h->execution_time = 0.0;
+    h->memory_required = (matrix_sizeof(h->table_a) * 2) +
+                         sizeof(floyd_hops_context);
+    return h;
+}
+
+void floyd_hops_context_free(floyd_hops_context* h)
+{
+    matrix_free(h->table_a);
+    matrix_free(h->table_d);
+    for(int s = 0; s < h->steps; s++) {
+        matrix_free(h->table_m[s]);
+    }
+    free(h);
+    return;
+}
+
+/*
+ * c = a (x) b, recorded as a new step stored in 'step'. Returns FALSE on
+ * error, as any step number, HOPS_ADJACENCY included, is a valid operand.
+ */
+static bool floyd_hops_step(floyd_hops_context* h, matrix* a, int left,
+                            matrix* b, int right, matrix* c, int* step)
+{
+    if(h->steps == HOPS_MAX_STEPS) {
+        return false;
+    }
+    matrix* mid = matrix_new(h->nodes, h->nodes, 0.0);
+    if(mid == NULL) {
+        return false;
+    }
+    minplus_product(a, b, c, mid);
+
+    *step = h->steps++;
+    h->table_m[*step] = mid;
+    h->left[*step] = left;
+    h->right[*step] = right;
+    h->memory_required += matrix_sizeof(mid);
+    return true;
+}
+
+bool floyd_hops(floyd_hops_context* h)
+{
+    /* Forget the products of any previous solve */
+    for(int s = 0; s < h->steps; s++) {
+        h->memory_required -= matrix_sizeof(h->table_m[s]);
+        matrix_free(h->table_m[s]);
+    }
+    h->steps = 0;
+    h->result = HOPS_ADJACENCY;
+
+    /* Start counting time */
+    GTimer* timer = g_timer_new();
+
+    int n = h->nodes;
+    matrix* base = matrix_new(n, n, PLUS_INF);
+    matrix* scratch = matrix_new(n, n, PLUS_INF);
+    if((base == NULL) || (scratch == NULL)) {
+        matrix_free(base);
+        matrix_free(scratch);
+        g_timer_destroy(timer);
+        return false;
+    }
+    matrix_copy(h->table_a, base);
+
+    /* Exponentiation by squaring, base is A^(2^s) */
+    int base_step = HOPS_ADJACENCY;
+    bool has_result = false;
+    bool success = true;
+    for(int e = h->hops; success; e >>= 1) {
+        if(e & 1) {
+            if(!has_result) {
+                matrix_copy(base, h->table_d);
+                h->result = base_step;
+                has_result = true;
+            } else {
+                success = floyd_hops_step(h, h->table_d, h->result,
+                                          base, base_step, scratch,
+                                          &h->result);
+                matrix* swap = h->table_d;
+                h->table_d = scratch;
+                scratch = swap;
+            }
+        }
+        if(e == 1) {
+            break;
+        }
+
+        success = success &&
+                  floyd_hops_step(h, base, base_step, base, base_step,
+                                  scratch, &base_step);
+        matrix* swap = base;
+        base = scratch;
+        scratch = swap;
+    }
+    matrix_free(base);
+    matrix_free(scratch);
+
+    /* Stop counting time */
+    g_timer_stop(timer);
+    h->execution_time = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+    return success;
+}
+
+float floyd_hops_distance(floyd_hops_context* h, int from, int to)
+{
+    return h->table_d->data[from][to];
+}
+
+static int floyd_hops_subpath(floyd_hops_context* h, int step,
+                              int from, int to, int* path, int n)
+{
+    /* Single edge or staying put */
+    if(step == HOPS_ADJACENCY) {
+        if(from != to) {
+            path[n++] = to;
+        }
+        return n;
+    }
+
+    int k = (int)h->table_m[step]->data[from][to];
+    n = floyd_hops_subpath(h, h->left[step], from, k, path, n);
+    return floyd_hops_subpath(h, h->right[step], k, to, path, n);
+}
+
+int floyd_hops_path(floyd_hops_context* h, int from, int to, int* path)
+{
+    if(h->table_d->data[from][to] == PLUS_INF) {
+        return 0;
+    }
+
+    path[0] = from;
+    return floyd_hops_subpath(h, h->result, from, to, path, 1);
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_FLOYD_HOPS
+#define H_FLOYD_HOPS
+
+#include "floyd.h"
+#include "minplus.h"
+
+/* A product operand that is the adjacency matrix itself */
+#define HOPS_ADJACENCY -1
+
+/* Squarings plus accumulations needed for any 'int' number of hops */
+#define HOPS_MAX_STEPS 64
+
+/**
+ * Hop-bounded shortest paths context data structure.
+ *
+ * Distances using at most 'hops' edges are computed by min-plus
+ * exponentiation by squaring of the adjacency matrix, in O(n^3 log hops).
+ * Every product keeps its table of midpoints so paths can be reconstructed.
+ */
+typedef struct {
+
+    /* Common */
+    int status;
+    double execution_time;
+    unsigned int memory_required;
+
+    /* Tables */
+    matrix* table_a;
+    matrix* table_d;
+
+    /* Products */
+    int steps;
+    matrix* table_m[HOPS_MAX_STEPS];
+    int left[HOPS_MAX_STEPS];
+    int right[HOPS_MAX_STEPS];
+    int result;
+
+    int nodes;
+    int hops;
+
+} floyd_hops_context;
+
+/**
+ * Create a hop-bounded context from the adjacency matrix stored in the D table
+ * of a Floyd's context. The Floyd's context can be freed afterwards.
+ *
+ * @param floyd_context, a floyd's context with the input graph in 'table_d'.
+ * @param hops, the maximum number of edges of a path, at least 1.
+ * @return a pointer to the context or NULL if enough memory could not be
+ *         allocated.
+ */
+floyd_hops_context* floyd_hops_context_new(floyd_context* c, int hops);
+void floyd_hops_context_free(floyd_hops_context* h);
+
+/**
+ * Compute the shortest distances using at most 'hops' edges. Products of a
+ * previous call are discarded, so it can be called again.
+ *
+ * @param floyd_hops_context, the hop-bounded context data structure.
+ * @return TRUE if execution was successful or FALSE if and error ocurred.
+ */
+bool floyd_hops(floyd_hops_context* h);
+
+/**
+ * Hop-bounded equivalents of floyd_distance() and floyd_path(). Paths never
+ * have more than 'hops' edges, so 'path' needs room for 'hops' + 1 nodes.
+ */
+float floyd_hops_distance(floyd_hops_context* h, int from, int to);
+int floyd_hops_path(floyd_hops_context* h, int from, int to, int* path);
+
+#endif
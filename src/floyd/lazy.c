@@ -0,0 +1,298 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "lazy.h"
+
+floyd_lazy_context* floyd_lazy_context_new(floyd_context* c,
+                                           size_t memory_limit)
+{
+    matrix* d = c->table_d;
+    int nodes = c->nodes;
+
+    /* Count edges and check weights are usable */
+    int edges = 0;
+    for(int i = 0; i < nodes; i++) {
+        for(int j = 0; j < nodes; j++) {
+            float weight = d->data[i][j];
+            if((i == j) || (weight == PLUS_INF)) {
+                continue;
+            }
+            if(weight < 0.0) {
+                return NULL;
+            }
+            edges++;
+        }
+    }
+
+    /* Allocate structure */
+    floyd_lazy_context* l = (floyd_lazy_context*)
+                                calloc(1, sizeof(floyd_lazy_context));
+    if(l == NULL) {
+        return NULL;
+    }
+
+    /* Try to allocate graph, heap and rows index */
+    l->edge_start = (int*) malloc((nodes + 1) * sizeof(int));
+    l->edge_to = (int*) malloc(max(edges, 1) * sizeof(int));
+    l->edge_weight = (float*) malloc(max(edges, 1) * sizeof(float));
+    l->heap_node = (int*) malloc((edges + 1) * sizeof(int));
+    l->heap_distance = (float*) malloc((edges + 1) * sizeof(float));
+    l->rows = (floyd_row**) calloc(nodes, sizeof(floyd_row*));
+    if((l->edge_start == NULL) || (l->edge_to == NULL) ||
+       (l->edge_weight == NULL) || (l->heap_node == NULL) ||
+       (l->heap_distance == NULL) || (l->rows == NULL)) {
+        floyd_lazy_context_free(l);
+        return NULL;
+    }
+
+    /* Build compressed sparse rows */
+    int e = 0;
+    for(int i = 0; i < nodes; i++) {
+        l->edge_start[i] = e;
+        for(int j = 0; j < nodes; j++) {
+            float weight = d->data[i][j];
+            if((i != j) && (weight != PLUS_INF)) {
+                l->edge_to[e] = j;
+                l->edge_weight[e] = weight;
+                e++;
+            }
+        }
+    }
+    l->edge_start[nodes] = e;
+
+    /* Size the cache */
+    size_t row_size = sizeof(floyd_row) + nodes * (sizeof(float) + sizeof(int));
+    l->max_rows = memory_limit / row_size;
+    if(l->max_rows < 1) {
+        l->max_rows = 1;
+    }
+    if(l->max_rows > nodes) {
+        l->max_rows = nodes;
+    }
+
+    l->nodes = nodes;
+    l->status = -1;
+    l->execution_time = 0.0;
+    l->memory_required = sizeof(floyd_lazy_context) +
+                         ((nodes + 1) * sizeof(int)) +
+                         (edges * (sizeof(int) + sizeof(float))) +
+                         ((edges + 1) * (sizeof(int) + sizeof(float))) +
+                         (nodes * sizeof(floyd_row*)) +
+                         (l->max_rows * row_size);
+    return l;
+}
+
+void floyd_lazy_context_free(floyd_lazy_context* l)
+{
+    floyd_row* row = l->newest;
+    while(row != NULL) {
+        floyd_row* older = row->older;
+        free(row->distance);
+        free(row->previous);
+        free(row);
+        row = older;
+    }
+    free(l->edge_start);
+    free(l->edge_to);
+    free(l->edge_weight);
+    free(l->heap_node);
+    free(l->heap_distance);
+    free(l->rows);
+    free(l);
+    return;
+}
+
+static void floyd_lazy_unlink(floyd_lazy_context* l, floyd_row* row)
+{
+    if(row->newer != NULL) {
+        row->newer->older = row->older;
+    } else {
+        l->newest = row->older;
+    }
+    if(row->older != NULL) {
+        row->older->newer = row->newer;
+    } else {
+        l->oldest = row->newer;
+    }
+    row->newer = NULL;
+    row->older = NULL;
+}
+
+static void floyd_lazy_push(floyd_lazy_context* l, floyd_row* row)
+{
+    row->newer = NULL;
+    row->older = l->newest;
+    if(l->newest != NULL) {
+        l->newest->newer = row;
+    }
+    l->newest = row;
+    if(l->oldest == NULL) {
+        l->oldest = row;
+    }
+}
+
+static void floyd_lazy_search(floyd_lazy_context* l, floyd_row* row)
+{
+    int* node = l->heap_node;
+    float* key = l->heap_distance;
+    float* distance = row->distance;
+    int* previous = row->previous;
+
+    for(int i = 0; i < l->nodes; i++) {
+        distance[i] = PLUS_INF;
+        previous[i] = -1;
+    }
+    distance[row->source] = 0.0;
+
+    /* Dijkstra with a binary heap and lazy deletion */
+    int size = 1;
+    node[0] = row->source;
+    key[0] = 0.0;
+    while(size > 0) {
+
+        /* Pop minimum */
+        int u = node[0];
+        float du = key[0];
+        size--;
+        int hole = 0;
+        while(true) {
+            int child = 2 * hole + 1;
+            if(child >= size) {
+                break;
+            }
+            if((child + 1 < size) && (key[child + 1] < key[child])) {
+                child++;
+            }
+            if(key[size] <= key[child]) {
+                break;
+            }
+            node[hole] = node[child];
+            key[hole] = key[child];
+            hole = child;
+        }
+        node[hole] = node[size];
+        key[hole] = key[size];
+
+        if(du > distance[u]) {
+            continue;
+        }
+
+        /* Relax edges */
+        for(int e = l->edge_start[u]; e < l->edge_start[u + 1]; e++) {
+            int v = l->edge_to[e];
+            float dv = du + l->edge_weight[e];
+            if(dv >= distance[v]) {
+                continue;
+            }
+            distance[v] = dv;
+            previous[v] = u;
+
+            /* Push */
+            hole = size++;
+            while(hole > 0) {
+                int parent = (hole - 1) / 2;
+                if(key[parent] <= dv) {
+                    break;
+                }
+                node[hole] = node[parent];
+                key[hole] = key[parent];
+                hole = parent;
+            }
+            node[hole] = v;
+            key[hole] = dv;
+        }
+    }
+}
+
+static floyd_row* floyd_lazy_row(floyd_lazy_context* l, int source)
+{
+    /* Cached */
+    floyd_row* row = l->rows[source];
+    if(row != NULL) {
+        l->hits++;
+        floyd_lazy_unlink(l, row);
+        floyd_lazy_push(l, row);
+        return row;
+    }
+    l->misses++;
+
+    /* Reuse the least recently used row or allocate a new one */
+    if(l->cached_rows == l->max_rows) {
+        row = l->oldest;
+        floyd_lazy_unlink(l, row);
+        l->rows[row->source] = NULL;
+    } else {
+        row = (floyd_row*) calloc(1, sizeof(floyd_row));
+        if(row == NULL) {
+            return NULL;
+        }
+        row->distance = (float*) malloc(l->nodes * sizeof(float));
+        row->previous = (int*) malloc(l->nodes * sizeof(int));
+        if((row->distance == NULL) || (row->previous == NULL)) {
+            free(row->distance);
+            free(row->previous);
+            free(row);
+            return NULL;
+        }
+        l->cached_rows++;
+    }
+
+    /* Compute the row */
+    GTimer* timer = g_timer_new();
+    row->source = source;
+    floyd_lazy_search(l, row);
+    g_timer_stop(timer);
+    l->execution_time += g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+
+    l->rows[source] = row;
+    floyd_lazy_push(l, row);
+    return row;
+}
+
+float floyd_lazy_distance(floyd_lazy_context* l, int from, int to)
+{
+    floyd_row* row = floyd_lazy_row(l, from);
+    if(row == NULL) {
+        l->status = FLOYD_OUT_OF_MEMORY;
+        return PLUS_INF;
+    }
+    l->status = FLOYD_SUCCESS;
+    return row->distance[to];
+}
+
+int floyd_lazy_path(floyd_lazy_context* l, int from, int to, int* path)
+{
+    floyd_row* row = floyd_lazy_row(l, from);
+    l->status = (row == NULL) ? FLOYD_OUT_OF_MEMORY : FLOYD_SUCCESS;
+    if((row == NULL) || (row->distance[to] == PLUS_INF)) {
+        return 0;
+    }
+
+    /* Walk back from the destination and reverse */
+    int n = 0;
+    for(int v = to; v != -1; v = row->previous[v]) {
+        path[n++] = v;
+    }
+    for(int i = 0; i < n / 2; i++) {
+        int swap = path[i];
+        path[i] = path[n - 1 - i];
+        path[n - 1 - i] = swap;
+    }
+    return n;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_FLOYD_LAZY
+#define H_FLOYD_LAZY
+
+#include "floyd.h"
+
+/**
+ * Cached single-source row: distances and predecessors from one source.
+ */
+typedef struct floyd_row {
+    int source;
+    float* distance;
+    int* previous;
+
+    /* LRU list, most recently used first */
+    struct floyd_row* newer;
+    struct floyd_row* older;
+} floyd_row;
+
+/**
+ * Lazy Floyd context data structure.
+ *
+ * Instead of solving every pair upfront, each source row is computed on
+ * demand with a single-source search the first time it's requested and kept
+ * in a LRU cache bounded by a memory limit. Edge weights must not be negative.
+ */
+typedef struct {
+
+    /* Common */
+    int status;
+    double execution_time;
+    unsigned int memory_required;
+
+    /* Graph, in compressed sparse rows */
+    int nodes;
+    int* edge_start;
+    int* edge_to;
+    float* edge_weight;
+
+    /* Search heap */
+    int* heap_node;
+    float* heap_distance;
+
+    /* Rows cache */
+    floyd_row** rows;
+    floyd_row* newest;
+    floyd_row* oldest;
+    int cached_rows;
+    int max_rows;
+
+    /* Statistics */
+    int hits;
+    int misses;
+
+} floyd_lazy_context;
+
+/**
+ * Create a lazy context from the adjacency matrix stored in the D table of a
+ * Floyd's context. The Floyd's context can be freed afterwards.
+ *
+ * @param floyd_context, a floyd's context with the input graph in 'table_d'.
+ * @param memory_limit, the maximum number of bytes used by cached rows. At
+ *        least one row is always cached.
+ * @return a pointer to the lazy context or NULL if enough memory could not be
+ *         allocated or the graph has negative weights.
+ */
+floyd_lazy_context* floyd_lazy_context_new(floyd_context* c,
+                                           size_t memory_limit);
+void floyd_lazy_context_free(floyd_lazy_context* l);
+
+/**
+ * Lazy equivalents of floyd_distance() and floyd_path().
+ *
+ * If the row of 'from' isn't cached and can't be allocated they return
+ * PLUS_INF and 0 as for an unreachable destination, so 'status' is set to
+ * FLOYD_OUT_OF_MEMORY, or FLOYD_SUCCESS when the row was available.
+ */
+float floyd_lazy_distance(floyd_lazy_context* l, int from, int to);
+int floyd_lazy_path(floyd_lazy_context* l, int from, int to, int* path);
+
+#endif
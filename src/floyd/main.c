@@ -25,24 +25,68 @@
 /* GUI */
 GtkWindow* window;
 GtkSpinButton* nodes;
-GtkTreeView* input;
+GtkWidget* input;
+GtkAdjustment* input_hadjustment;
+GtkAdjustment* input_vadjustment;
+GtkWidget* cell_popover;
+GtkEntry* cell_entry;
 GtkImage* graph;
 
 GtkFileChooser* load_dialog;
 GtkFileChooser* save_dialog;
 
 /* Context */
-floyd_context* c = NULL;
 matrix* adj_matrix = NULL;
 char** names = NULL;
 
+/* Matrix view, only the visible cells are drawn */
+#define CELL_WIDTH 60
+#define CELL_HEIGHT 24
+int edit_row = -1;
+int edit_column = -1;
+
+/* Graph preview, rendered in a thread after edits settle */
+#define GRAPH_DELAY 400
+guint graph_timeout = 0;
+bool graph_rendering = false;
+bool graph_dirty = false;
+
+typedef struct {
+    matrix* adjacency;
+    char** names;
+    GdkPixbuf* pixbuf;
+} graph_job;
+
+/* Solve and report, run in a thread on a copy of the input */
+typedef struct {
+    floyd_context* c;
+    GtkWidget* button;
+    bool success;
+    bool report_created;
+    int as_pdf;
+} solve_job;
+
 /* Functions */
 bool change_matrix(int size);
 void change_matrix_cb(GtkSpinButton* spinbutton, gpointer user_data);
+char* cell_text(int row, int column);
+void update_adjustments();
+void adjustment_changed_cb(GtkAdjustment* adjustment, gpointer user_data);
+void size_allocate_cb(GtkWidget* widget, GdkRectangle* allocation,
+                      gpointer user_data);
+gboolean draw_cb(GtkWidget* widget, cairo_t* cr, gpointer user_data);
+gboolean scroll_cb(GtkWidget* widget, GdkEventScroll* event,
+                   gpointer user_data);
+gboolean button_press_cb(GtkWidget* widget, GdkEventButton* event,
+                         gpointer user_data);
+void cell_edited_cb(GtkEntry* entry, gpointer user_data);
 void update_graph();
-void cell_edited_cb(GtkCellRendererText* renderer, gchar* path,
-                    gchar* new_text, gpointer user_data);
+gboolean update_graph_cb(gpointer user_data);
+gpointer render_graph(gpointer data);
+gboolean graph_ready_cb(gpointer data);
 void process(GtkButton* button, gpointer user_data);
+gpointer solve(gpointer data);
+gboolean solve_ready_cb(gpointer data);
 
 void save_cb(GtkButton* button, gpointer user_data);
 void load_cb(GtkButton* button, gpointer user_data);
@@ -72,7 +116,11 @@ int main(int argc, char **argv)
     /* Get pointers to objects */
     window = GTK_WINDOW(gtk_builder_get_object(builder, "window"));
     nodes = GTK_SPIN_BUTTON(gtk_builder_get_object(builder, "nodes"));
-    input = GTK_TREE_VIEW(gtk_builder_get_object(builder, "input"));
+    input = GTK_WIDGET(gtk_builder_get_object(builder, "input"));
+    input_hadjustment = GTK_ADJUSTMENT(
+                    gtk_builder_get_object(builder, "input_hadjustment"));
+    input_vadjustment = GTK_ADJUSTMENT(
+                    gtk_builder_get_object(builder, "input_vadjustment"));
     graph = GTK_IMAGE(gtk_builder_get_object(builder, "graph"));
 
     load_dialog = GTK_FILE_CHOOSER(gtk_builder_get_object(builder, "load_dialog"));
@@ -84,6 +132,29 @@ int main(int argc, char **argv)
     gtk_file_chooser_add_filter(load_dialog, file_filter);
     gtk_file_chooser_add_filter(save_dialog, file_filter);
 
+    /* Configure matrix view */
+    gtk_widget_add_events(input, GDK_BUTTON_PRESS_MASK |
+                                 GDK_SCROLL_MASK |
+                                 GDK_SMOOTH_SCROLL_MASK);
+    g_signal_connect(G_OBJECT(input), "draw", G_CALLBACK(draw_cb), NULL);
+    g_signal_connect(G_OBJECT(input), "scroll-event",
+                     G_CALLBACK(scroll_cb), NULL);
+    g_signal_connect(G_OBJECT(input), "button-press-event",
+                     G_CALLBACK(button_press_cb), NULL);
+    g_signal_connect(G_OBJECT(input), "size-allocate",
+                     G_CALLBACK(size_allocate_cb), NULL);
+    g_signal_connect(G_OBJECT(input_hadjustment), "value-changed",
+                     G_CALLBACK(adjustment_changed_cb), NULL);
+    g_signal_connect(G_OBJECT(input_vadjustment), "value-changed",
+                     G_CALLBACK(adjustment_changed_cb), NULL);
+
+    /* Cells are edited in a popover */
+    cell_popover = gtk_popover_new(input);
+    cell_entry = GTK_ENTRY(gtk_entry_new());
+    gtk_container_add(GTK_CONTAINER(cell_popover), GTK_WIDGET(cell_entry));
+    g_signal_connect(G_OBJECT(cell_entry), "activate",
+                     G_CALLBACK(cell_edited_cb), NULL);
+
     /* Connect signals */
     gtk_builder_connect_signals(builder, NULL);
 
@@ -109,230 +180,271 @@ bool change_matrix(int size)
         old_size = adj_matrix->columns;
     }
 
-    /* Try to create the adjacency matrix */
-    if(adj_matrix != NULL) {
-        matrix_free(adj_matrix);
-    }
-    adj_matrix = matrix_new(size, size, PLUS_INF);
-    if(adj_matrix == NULL) {
+    /* Try to create the adjacency matrix and names array */
+    matrix* new_matrix = matrix_new(size, size, PLUS_INF);
+    if(new_matrix == NULL) {
         return false;
     }
-    for(int i = 0; i < size; i++) {
-        adj_matrix->data[i][i] = 0.0;
+    char** new_names = (char**) malloc(size * sizeof(char*));
+    if(new_names == NULL) {
+        matrix_free(new_matrix);
+        return false;
     }
 
-    /* Try to create names array */
-    if(names != NULL) {
-        for(int i = 0; i < old_size; i++) {
-            free(names[i]);
+    /* Keep what was already edited */
+    for(int i = 0; i < size; i++) {
+        if(i < old_size) {
+            new_names[i] = names[i];
+            for(int j = 0; j < min(size, old_size); j++) {
+                new_matrix->data[i][j] = adj_matrix->data[i][j];
+            }
+        } else {
+            new_names[i] = sequence_name(i);
         }
-        free(names);
-    }
-    names = (char**) malloc(size * sizeof(char*));
-    if(names == NULL) {
-        matrix_free(adj_matrix);
-        return false;
+        new_matrix->data[i][i] = 0.0;
     }
-    for(int i = 0; i < size; i++) {
-        names[i] = sequence_name(i);
+    for(int i = size; i < old_size; i++) {
+        g_free(names[i]);
     }
-
-    /* Create the dynamic types array */
-    int rsize = size + 1;
-    GType* types = (GType*) malloc(3 * rsize * sizeof(GType));
-    if(types == NULL) {
+    if(adj_matrix != NULL) {
         matrix_free(adj_matrix);
-        return false;
-    }
-    for(int i = 0; i < rsize; i++) {
-        types[i] = G_TYPE_STRING;
-        types[rsize + i] = G_TYPE_BOOLEAN;     /* Editable */
-        types[2 * rsize + i] = G_TYPE_BOOLEAN; /* Background set */
+        free(names);
     }
+    adj_matrix = new_matrix;
+    names = new_names;
 
-    /* Create and fill the new model */
-    GtkListStore* model = gtk_list_store_newv(3 * rsize, types);
-    GtkTreeIter iter;
-
-    GValue init = G_VALUE_INIT;
-    g_value_init(&init, G_TYPE_STRING);
-
-    GValue initb = G_VALUE_INIT;
-    g_value_init(&initb, G_TYPE_BOOLEAN);
-
-    for(int i = 0; i < rsize; i++) {
-        gtk_list_store_append(model, &iter);
-
-        /* First row */
-        if(i == 0) {
-            for(int j = 0; j < rsize; j++) {
-                /* Set value */
-                if(j > 0) {
-                    g_value_set_string(&init, sequence_name(j - 1));
-                    g_value_set_boolean(&initb, true);
-                } else {
-                    g_value_set_string(&init, "");
-                    g_value_set_boolean(&initb, false);
-                }
-                gtk_list_store_set_value(model, &iter, j, &init);
-
-                /* Set editable */
-                gtk_list_store_set_value(model, &iter, rsize + j, &initb);
+    /* Refresh view */
+    gtk_widget_hide(cell_popover);
+    update_adjustments();
+    gtk_widget_queue_draw(input);
+    update_graph();
 
-                /* Set background set */
-                g_value_set_boolean(&initb, true);
-                gtk_list_store_set_value(model, &iter, 2 * rsize + j, &initb);
-            }
-            continue;
-        }
+    return true;
+}
 
-        /* Other rows, first cell */
-        /* Set value */
-        g_value_set_string(&init, sequence_name(i - 1));
-        gtk_list_store_set_value(model, &iter, 0, &init);
+void change_matrix_cb(GtkSpinButton* spinbutton, gpointer user_data)
+{
+    /* Get the number of requested nodes */
+    int value = gtk_spin_button_get_value_as_int(spinbutton);
+    bool success = change_matrix(value);
+    if(!success) {
+        show_error(window, "Unable to allocate enough memory for "
+                           "this problem. Sorry.");
+    }
+    return;
+}
 
-        /* Set editable */
-        g_value_set_boolean(&initb, false);
-        gtk_list_store_set_value(model, &iter, rsize, &initb);
+char* cell_text(int row, int column)
+{
+    float d = adj_matrix->data[row][column];
+    if(d == PLUS_INF) {
+        return g_strdup("oo");
+    }
+    if(floorf(d) == d) {
+        return g_strdup_printf("%.0f", d);
+    }
+    return g_strdup_printf("%.2f", d);
+}
 
-        /* Set background set */
-        g_value_set_boolean(&initb, true);
-        gtk_list_store_set_value(model, &iter, 2 * rsize, &initb);
+void update_adjustments()
+{
+    int size = adj_matrix->columns;
+    int width = max(gtk_widget_get_allocated_width(input) - CELL_WIDTH, 1);
+    int height = max(gtk_widget_get_allocated_height(input) - CELL_HEIGHT, 1);
+
+    gtk_adjustment_configure(input_hadjustment,
+                    gtk_adjustment_get_value(input_hadjustment),
+                    0.0, size * CELL_WIDTH,
+                    CELL_WIDTH, width, width);
+    gtk_adjustment_configure(input_vadjustment,
+                    gtk_adjustment_get_value(input_vadjustment),
+                    0.0, size * CELL_HEIGHT,
+                    CELL_HEIGHT, height, height);
+}
 
-        /* Other rows, other cells */
-        for(int j = 1; j < rsize; j++) {
+void adjustment_changed_cb(GtkAdjustment* adjustment, gpointer user_data)
+{
+    gtk_widget_hide(cell_popover);
+    gtk_widget_queue_draw(input);
+}
 
-            /* Set value */
-            if(i == j) {
-                g_value_set_string(&init, "0");
-            } else {
-                g_value_set_string(&init, "oo");
-            }
-            gtk_list_store_set_value(model, &iter, j, &init);
+void size_allocate_cb(GtkWidget* widget, GdkRectangle* allocation,
+                      gpointer user_data)
+{
+    update_adjustments();
+}
 
-            /* Set editable */
-            g_value_set_boolean(&initb, i != j);
-            gtk_list_store_set_value(model, &iter, rsize + j, &initb);
+static void draw_cell(cairo_t* cr, PangoLayout* layout, double x, double y,
+                      const char* text, double shade)
+{
+    cairo_save(cr);
+    cairo_rectangle(cr, x, y, CELL_WIDTH, CELL_HEIGHT);
+    cairo_clip_preserve(cr);
+
+    /* Background and border */
+    cairo_set_source_rgb(cr, shade, shade, shade);
+    cairo_fill_preserve(cr);
+    cairo_set_source_rgb(cr, 0.7, 0.7, 0.7);
+    cairo_set_line_width(cr, 1.0);
+    cairo_stroke(cr);
+
+    /* Centered text */
+    int text_width, text_height;
+    pango_layout_set_text(layout, text, -1);
+    pango_layout_get_pixel_size(layout, &text_width, &text_height);
+    cairo_set_source_rgb(cr, 0.0, 0.0, 0.0);
+    cairo_move_to(cr, x + (CELL_WIDTH - text_width) / 2.0,
+                      y + (CELL_HEIGHT - text_height) / 2.0);
+    pango_cairo_show_layout(cr, layout);
+
+    cairo_restore(cr);
+}
 
-            /* Set background set */
-            g_value_set_boolean(&initb, false);
-            gtk_list_store_set_value(model, &iter, 2 * rsize + j, &initb);
+gboolean draw_cb(GtkWidget* widget, cairo_t* cr, gpointer user_data)
+{
+    if(adj_matrix == NULL) {
+        return FALSE;
+    }
+
+    int size = adj_matrix->columns;
+    int width = gtk_widget_get_allocated_width(widget);
+    int height = gtk_widget_get_allocated_height(widget);
+    double x0 = gtk_adjustment_get_value(input_hadjustment);
+    double y0 = gtk_adjustment_get_value(input_vadjustment);
+
+    /* Visible range */
+    int first_column = (int)(x0 / CELL_WIDTH);
+    int first_row = (int)(y0 / CELL_HEIGHT);
+    int last_column = min(size, first_column + (width / CELL_WIDTH) + 2);
+    int last_row = min(size, first_row + (height / CELL_HEIGHT) + 2);
+
+    PangoLayout* layout = gtk_widget_create_pango_layout(widget, NULL);
+    cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
+    cairo_paint(cr);
+
+    /* Cells */
+    for(int i = first_row; i < last_row; i++) {
+        double y = CELL_HEIGHT + (i * CELL_HEIGHT) - y0;
+        for(int j = first_column; j < last_column; j++) {
+            double x = CELL_WIDTH + (j * CELL_WIDTH) - x0;
+            char* text = cell_text(i, j);
+            draw_cell(cr, layout, x, y, text, (i == j) ? 0.93 : 1.0);
+            g_free(text);
         }
     }
 
-    /* Clear the previous matrix */
-    for(int i = gtk_tree_view_get_n_columns(input) - 1; i >= 0; i--) {
-        gtk_tree_view_remove_column(input,
-                                        gtk_tree_view_get_column(input, i)
-                                    );
-    }
-
-    /* Create the matrix */
-    for(int i = 0; i < rsize; i++) {
-        /* Configure cell */
-        GtkCellRenderer* cell = gtk_cell_renderer_text_new();
-        g_object_set(cell, "cell-background", "Black", NULL);
-        g_signal_connect(G_OBJECT(cell),
-                         "edited", G_CALLBACK(cell_edited_cb),
-                         GINT_TO_POINTER(i));
-        /* Configure column */
-        GtkTreeViewColumn* column = gtk_tree_view_column_new_with_attributes(
-                                        "", cell,  /* Title, renderer */
-                                        "text", i,
-                                        "editable", rsize + i,
-                                        "cell-background-set", 2 * rsize + i,
-                                        NULL);
-        gtk_tree_view_append_column(input, column);
-    }
-    GtkTreeViewColumn* close_column = gtk_tree_view_column_new();
-    gtk_tree_view_append_column(input, close_column);
-
-    /* Set the new model */
-    gtk_tree_view_set_model(input, GTK_TREE_MODEL(model));
-
-    /* Update the graph */
-    update_graph();
-
-    /* Free resources */
-    g_object_unref(G_OBJECT(model));
-    free(types);
+    /* Headers, on top of the cells */
+    for(int j = first_column; j < last_column; j++) {
+        draw_cell(cr, layout, CELL_WIDTH + (j * CELL_WIDTH) - x0, 0.0,
+                  names[j], 0.8);
+    }
+    for(int i = first_row; i < last_row; i++) {
+        draw_cell(cr, layout, 0.0, CELL_HEIGHT + (i * CELL_HEIGHT) - y0,
+                  names[i], 0.8);
+    }
+    draw_cell(cr, layout, 0.0, 0.0, "", 0.8);
 
-    return true;
+    g_object_unref(layout);
+    return TRUE;
 }
 
-void update_graph()
+gboolean scroll_cb(GtkWidget* widget, GdkEventScroll* event,
+                   gpointer user_data)
 {
-    /* Create graph */
-    floyd_graph(adj_matrix, names);
-    if(gv2png("graph", "reports") < 0) {
-        gtk_image_set_from_pixbuf(graph, NULL);
-        return;
+    double dx = 0.0;
+    double dy = 0.0;
+
+    if(event->direction == GDK_SCROLL_UP) {
+        dy = -1.0;
+    } else if(event->direction == GDK_SCROLL_DOWN) {
+        dy = 1.0;
+    } else if(event->direction == GDK_SCROLL_LEFT) {
+        dx = -1.0;
+    } else if(event->direction == GDK_SCROLL_RIGHT) {
+        dx = 1.0;
+    } else {
+        gdk_event_get_scroll_deltas((GdkEvent*) event, &dx, &dy);
     }
 
-    /* Load image */
-    GError* error = NULL;
-    //GdkPixbuf* pixbuf = gdk_pixbuf_new_from_file_at_size(
-                            //"reports/graph.png", 300, 300, &error);
-    GdkPixbuf* pixbuf = gdk_pixbuf_new_from_file("reports/graph.png", &error);
-    if(pixbuf == NULL) {
-        if(error) {
-            g_warning("%s", error->message);
-            g_error_free(error);
-        } else {
-            g_warning("Unknown error while loading the graph.");
-        }
-        return;
+    /* Shift scrolls horizontally */
+    if(event->state & GDK_SHIFT_MASK) {
+        double swap = dx;
+        dx = dy;
+        dy = swap;
     }
-    gtk_image_set_from_pixbuf(graph, pixbuf);
 
-    g_object_unref(pixbuf);
+    gtk_adjustment_set_value(input_hadjustment,
+                gtk_adjustment_get_value(input_hadjustment) +
+                (dx * 3 * CELL_WIDTH));
+    gtk_adjustment_set_value(input_vadjustment,
+                gtk_adjustment_get_value(input_vadjustment) +
+                (dy * 3 * CELL_HEIGHT));
+    return TRUE;
 }
 
-void cell_edited_cb(GtkCellRendererText* renderer, gchar* path,
-                    gchar* new_text, gpointer user_data)
+gboolean button_press_cb(GtkWidget* widget, GdkEventButton* event,
+                         gpointer user_data)
 {
-    int row = atoi(path);
-    int column = GPOINTER_TO_INT(user_data);
-    printf("%s at (%i, %i)\n", new_text, row, column);
-
-    /* Validate row and column just in case */
-    if((row == column) || column == 0) {
-        return;
+    if((event->button != 1) || (adj_matrix == NULL)) {
+        return FALSE;
+    }
+    gtk_widget_grab_focus(widget);
+
+    /* Find cell, -1 is the header */
+    int size = adj_matrix->columns;
+    double x0 = gtk_adjustment_get_value(input_hadjustment);
+    double y0 = gtk_adjustment_get_value(input_vadjustment);
+    int row = -1;
+    int column = -1;
+    if(event->x >= CELL_WIDTH) {
+        column = (int)((event->x - CELL_WIDTH + x0) / CELL_WIDTH);
+    }
+    if(event->y >= CELL_HEIGHT) {
+        row = (int)((event->y - CELL_HEIGHT + y0) / CELL_HEIGHT);
+    }
+
+    /* Corner, diagonal and out of the matrix are not editable */
+    if((row == column) || (row >= size) || (column >= size)) {
+        return TRUE;
+    }
+    edit_row = row;
+    edit_column = column;
+
+    /* Show editor over the cell */
+    GdkRectangle cell;
+    cell.x = (column < 0) ? 0 : CELL_WIDTH + (column * CELL_WIDTH) - x0;
+    cell.y = (row < 0) ? 0 : CELL_HEIGHT + (row * CELL_HEIGHT) - y0;
+    cell.width = CELL_WIDTH;
+    cell.height = CELL_HEIGHT;
+
+    if(row < 0) {
+        gtk_entry_set_text(cell_entry, names[column]);
+    } else if(column < 0) {
+        gtk_entry_set_text(cell_entry, names[row]);
+    } else {
+        char* text = cell_text(row, column);
+        gtk_entry_set_text(cell_entry, text);
+        g_free(text);
     }
+    gtk_popover_set_pointing_to(GTK_POPOVER(cell_popover), &cell);
+    gtk_widget_show_all(cell_popover);
+    gtk_widget_grab_focus(GTK_WIDGET(cell_entry));
 
-    /* Get reference to model */
-    GtkTreePath* model_path = gtk_tree_path_new_from_string(path);
-    GtkTreeIter iter;
-    gtk_tree_model_get_iter(gtk_tree_view_get_model(input), &iter, model_path);
-    gtk_tree_path_free(model_path);
+    return TRUE;
+}
 
-    GValue value = G_VALUE_INIT;
-    g_value_init(&value, G_TYPE_STRING);
+void cell_edited_cb(GtkEntry* entry, gpointer user_data)
+{
+    char* new_text = (char*) gtk_entry_get_text(entry);
+    gtk_widget_hide(cell_popover);
 
     /* A node is being renamed */
-    if(row == 0) {
+    if((edit_row < 0) || (edit_column < 0)) {
+        int node = (edit_row < 0) ? edit_column : edit_row;
         if(!is_empty_string(new_text)) {
-            /* Set node at first row */
-            g_value_set_string(&value, new_text);
-            gtk_list_store_set_value(
-                            GTK_LIST_STORE(gtk_tree_view_get_model(input)),
-                            &iter, column, &value);
-
-            /* Set node at first column */
-            char* at_y = g_strdup_printf("%i", column);
-            model_path = gtk_tree_path_new_from_string(at_y);
-            gtk_tree_model_get_iter(
-                    gtk_tree_view_get_model(input), &iter, model_path);
-            gtk_tree_path_free(model_path);
-            g_free(at_y);
-            gtk_list_store_set_value(
-                            GTK_LIST_STORE(gtk_tree_view_get_model(input)),
-                            &iter, 0, &value);
-
-            g_free(names[column - 1]);
-            names[column - 1] = g_strdup(new_text);
-
-            /* Update the graph */
+            g_free(names[node]);
+            names[node] = g_strdup(new_text);
+            gtk_widget_queue_draw(input);
             update_graph();
         }
         return;
@@ -342,14 +454,8 @@ void cell_edited_cb(GtkCellRendererText* renderer, gchar* path,
     /* INFINITY */
     int is_inf = strncmp(new_text, "oo", 2);
     if(is_inf == 0 || is_empty_string(new_text)) {
-        g_value_set_string(&value, "oo");
-        gtk_list_store_set_value(
-                            GTK_LIST_STORE(gtk_tree_view_get_model(input)),
-                            &iter, column, &value);
-
-        adj_matrix->data[row - 1][column - 1] = PLUS_INF;
-
-        /* Update the graph */
+        adj_matrix->data[edit_row][edit_column] = PLUS_INF;
+        gtk_widget_queue_draw(input);
         update_graph();
         return;
     }
@@ -357,79 +463,191 @@ void cell_edited_cb(GtkCellRendererText* renderer, gchar* path,
     char* end;
     int distance = (int) strtol(new_text, &end, 10);
     if((end != new_text) && (*end == '\0') && (distance > 0)) {
-        char* distance_as_string = g_strdup_printf("%i", distance);
-        g_value_set_string(&value, distance_as_string);
-        gtk_list_store_set_value(
-                            GTK_LIST_STORE(gtk_tree_view_get_model(input)),
-                            &iter, column, &value);
-        g_free(distance_as_string);
+        adj_matrix->data[edit_row][edit_column] = (float) distance;
+        gtk_widget_queue_draw(input);
+        update_graph();
+    }
+}
+
+void update_graph()
+{
+    /* Restart the delay, only the last of a burst of edits is rendered */
+    if(graph_timeout != 0) {
+        g_source_remove(graph_timeout);
+    }
+    graph_timeout = g_timeout_add(GRAPH_DELAY, update_graph_cb, NULL);
+}
 
-        adj_matrix->data[row - 1][column - 1] = (float) distance;
+gboolean update_graph_cb(gpointer user_data)
+{
+    graph_timeout = 0;
 
-        /* Update the graph */
-        update_graph();
-        return;
+    /* One render at a time, the newest edits follow when it's done */
+    if(graph_rendering) {
+        graph_dirty = true;
+        return FALSE;
+    }
+
+    /* Graphviz can't draw graphs this big in a reasonable time */
+    int size = adj_matrix->columns;
+    if(size > FLOYD_GRAPH_MAX_NODES) {
+        gtk_image_set_from_pixbuf(graph, NULL);
+        return FALSE;
     }
-    return;
 
+    /* Render a snapshot, edits can continue meanwhile */
+    graph_job* job = (graph_job*) malloc(sizeof(graph_job));
+    if(job == NULL) {
+        return FALSE;
+    }
+    job->adjacency = matrix_new(size, size, PLUS_INF);
+    job->names = (char**) malloc(size * sizeof(char*));
+    job->pixbuf = NULL;
+    if((job->adjacency == NULL) || (job->names == NULL)) {
+        matrix_free(job->adjacency);
+        free(job->names);
+        free(job);
+        return FALSE;
+    }
+    matrix_copy(adj_matrix, job->adjacency);
+    for(int i = 0; i < size; i++) {
+        job->names[i] = g_strdup(names[i]);
+    }
+
+    graph_rendering = true;
+    graph_dirty = false;
+    g_thread_unref(g_thread_new("graph", render_graph, job));
+    return FALSE;
 }
 
-void change_matrix_cb(GtkSpinButton* spinbutton, gpointer user_data)
+gpointer render_graph(gpointer data)
 {
-    /* Get the number of requested nodes */
-    int value = gtk_spin_button_get_value_as_int(spinbutton);
-    bool success = change_matrix(value);
-    if(!success) {
-        show_error(window, "Unable to allocate enough memory for "
-                           "this problem. Sorry.");
+    graph_job* job = (graph_job*) data;
+
+    /* Create graph */
+    floyd_graph_as(job->adjacency, job->names, "preview");
+    if(gv2png("preview", "reports") >= 0) {
+
+        /* Load image */
+        GError* error = NULL;
+        job->pixbuf = gdk_pixbuf_new_from_file("reports/preview.png", &error);
+        if(job->pixbuf == NULL) {
+            if(error) {
+                g_warning("%s", error->message);
+                g_error_free(error);
+            } else {
+                g_warning("Unknown error while loading the graph.");
+            }
+        }
     }
-    return;
+
+    /* Widgets are only touched from the main loop */
+    g_idle_add(graph_ready_cb, job);
+    return NULL;
+}
+
+gboolean graph_ready_cb(gpointer data)
+{
+    graph_job* job = (graph_job*) data;
+
+    gtk_image_set_from_pixbuf(graph, job->pixbuf);
+    if(job->pixbuf != NULL) {
+        g_object_unref(job->pixbuf);
+    }
+
+    /* Free resources */
+    for(int i = 0; i < job->adjacency->rows; i++) {
+        g_free(job->names[i]);
+    }
+    free(job->names);
+    matrix_free(job->adjacency);
+    free(job);
+
+    graph_rendering = false;
+    if(graph_dirty) {
+        update_graph();
+    }
+    return FALSE;
 }
 
 void process(GtkButton* button, gpointer user_data)
 {
     /* Try to create the new context */
-    if(c != NULL) {
-        floyd_context_free(c);
-    }
-    c = floyd_context_new(adj_matrix->columns);
-    if(c == NULL) {
+    solve_job* job = (solve_job*) malloc(sizeof(solve_job));
+    floyd_context* c = floyd_context_new(adj_matrix->columns);
+    if((job == NULL) || (c == NULL)) {
+        free(job);
+        if(c != NULL) {
+            floyd_context_free(c);
+        }
         show_error(window, "Unable to allocate enough memory for "
                            "this problem. Sorry.");
         return;
     }
 
-    /* Copy adjacency matrix and names */
+    /* Copy adjacency matrix and names, edits can continue meanwhile */
     matrix_copy(adj_matrix, c->table_d);
     for(int i = 0; i < adj_matrix->columns; i++) {
-        c->names[i] = names[i];
+        c->names[i] = g_strdup(names[i]);
     }
 
+    /* One solve at a time */
+    job->c = c;
+    job->button = GTK_WIDGET(button);
+    gtk_widget_set_sensitive(job->button, FALSE);
+    g_thread_unref(g_thread_new("floyd", solve, job));
+}
+
+gpointer solve(gpointer data)
+{
+    solve_job* job = (solve_job*) data;
+
     /* Execute algorithm */
-    bool success = floyd(c);
-    if(!success) {
+    job->success = floyd(job->c);
+
+    /* Generate report */
+    job->report_created = floyd_report(job->c);
+    job->as_pdf = -1;
+    if(job->report_created) {
+        job->as_pdf = latex2pdf("floyd", "reports");
+    }
+
+    /* Widgets are only touched from the main loop */
+    g_idle_add(solve_ready_cb, job);
+    return NULL;
+}
+
+gboolean solve_ready_cb(gpointer data)
+{
+    solve_job* job = (solve_job*) data;
+
+    if(!job->success) {
         show_error(window, "Error while processing the information.\n"
                            "Please check your data.");
     }
-
-    /* Generate report */
-    bool report_created = floyd_report(c);
-    if(!report_created) {
+    if(!job->report_created) {
         show_error(window, "Report could not be created.\n"
                            "Please check your data.");
     } else {
         printf("Report created at reports/floyd.tex\n");
-
-        int as_pdf = latex2pdf("floyd", "reports");
-        if(as_pdf == 0) {
+        if(job->as_pdf == 0) {
             printf("PDF version available at reports/floyd.pdf\n");
         } else {
             char* error = g_strdup_printf("Unable to convert report to PDF.\n"
-                                          "Status: %i.", as_pdf);
+                                          "Status: %i.", job->as_pdf);
             show_error(window, error);
             g_free(error);
         }
     }
+
+    /* Free resources */
+    for(int i = 0; i < job->c->nodes; i++) {
+        g_free(job->c->names[i]);
+    }
+    floyd_context_free(job->c);
+    gtk_widget_set_sensitive(job->button, TRUE);
+    free(job);
+    return FALSE;
 }
 
 void save_cb(GtkButton* button, gpointer user_data)
@@ -565,69 +783,31 @@ void load(FILE* file)
     gtk_spin_button_set_value(nodes, (gdouble)num_nodes);
 
     /* Load node names */
-    GtkListStore* model = GTK_LIST_STORE(gtk_tree_view_get_model(input));
-    GtkTreeIter iter;
-    bool has_row = gtk_tree_model_get_iter_first(
-                            GTK_TREE_MODEL(model), &iter);
-    if(!has_row) {
-        return;
-    }
-
-    char* name_i = NULL;
-    GValue name_v = G_VALUE_INIT;
-
     for(int i = 0; i < num_nodes; i++) {
-        /* Get name */
-        name_i = get_line(file);
-        /* Get create GValue */
-        g_value_init(&name_v, G_TYPE_STRING);
-        g_value_set_string(&name_v, name_i);
-        /* Store */
-        gtk_list_store_set_value(model, &iter, i + 1, &name_v);
+        char* name_i = get_line(file);
+        g_free(names[i]);
         names[i] = g_strdup(name_i);
-        /* Free resources */
-        g_value_unset(&name_v);
         free(name_i);
     }
 
     /* Load adjacency matrix */
-    gtk_tree_model_iter_next(GTK_TREE_MODEL(model), &iter);
-
     char cell_i[12];
-    GValue cell_v = G_VALUE_INIT;
-
     for(int i = 0; i < num_nodes; i++) {
         for(int j = 0; j < num_nodes; j++) {
             /* Get string */
-            fscanf(file, "%s", cell_i);
+            fscanf(file, "%11s", cell_i);
 
             /* Set the cell */
             if(i != j) {
-                g_value_init(&cell_v, G_TYPE_STRING);
-
-                /* Check if INFINITY */
                 if(strncmp((char*) &cell_i, "oo", 2) == 0) {
                     adj_matrix->data[i][j] = PLUS_INF;
-                    g_value_set_string(&cell_v, "oo");
                 } else {
-                    int cell = atoi((char*) &cell_i);
-                    adj_matrix->data[i][j] = cell;
-                    g_value_set_string(&cell_v, (char*) &cell_i);
+                    adj_matrix->data[i][j] = atoi((char*) &cell_i);
                 }
-
-                /* Set value in GUI */
-                gtk_list_store_set_value(model, &iter, j + 1, &cell_v);
-                g_value_unset(&cell_v);
-
-                /* Load name */
-                g_value_init(&cell_v, G_TYPE_STRING);
-                g_value_set_string(&cell_v, names[i]);
-                gtk_list_store_set_value(model, &iter, 0, &cell_v);
-                g_value_unset(&cell_v);
             }
         }
-        gtk_tree_model_iter_next(GTK_TREE_MODEL(model), &iter);
     }
 
+    gtk_widget_queue_draw(input);
     update_graph();
 }
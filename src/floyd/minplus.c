@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "minplus.h"
+
+SIMD_CLONES
+static void minplus_row(float a_ik, const float* restrict b_k,
+                        float* restrict c_i, float* restrict mid_i,
+                        float k, int j0, int j1)
+{
+    for(int j = j0; j < j1; j++) {
+        float candidate = a_ik + b_k[j];
+        bool better = candidate < c_i[j];
+        c_i[j] = better ? candidate : c_i[j];
+        mid_i[j] = better ? k : mid_i[j];
+    }
+}
+
+void minplus_block(float** a, float** b, float** c, float** mid,
+                   int i0, int i1, int k0, int k1, int j0, int j1,
+                   int offset)
+{
+    for(int i = i0; i < i1; i++) {
+        for(int k = k0; k < k1; k++) {
+            float a_ik = a[i][k];
+            if(a_ik == PLUS_INF) {
+                continue;
+            }
+            minplus_row(a_ik, b[k], c[i], mid[i], (float)(k + offset),
+                        j0, j1);
+        }
+    }
+}
+
+void minplus_product(matrix* a, matrix* b, matrix* c, matrix* mid)
+{
+    int n = a->rows;
+
+    matrix_fill(c, PLUS_INF);
+    matrix_fill(mid, 0.0);
+
+    for(int j0 = 0; j0 < n; j0 += MINPLUS_BLOCK_COLUMNS) {
+        int j1 = min(j0 + MINPLUS_BLOCK_COLUMNS, n);
+        for(int k0 = 0; k0 < n; k0 += MINPLUS_BLOCK_ROWS) {
+            int k1 = min(k0 + MINPLUS_BLOCK_ROWS, n);
+            minplus_block(a->data, b->data, c->data, mid->data,
+                          0, n, k0, k1, j0, j1, 0);
+        }
+    }
+}
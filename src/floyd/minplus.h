@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_FLOYD_MINPLUS
+#define H_FLOYD_MINPLUS
+
+#include "utils.h"
+#include "matrix.h"
+
+/* Tile sizes of the min-plus product, a tile of B stays in cache */
+#define MINPLUS_BLOCK_ROWS 64
+#define MINPLUS_BLOCK_COLUMNS 512
+
+/**
+ * Min-plus product C = A (x) B, that is, C[i][j] = min_k A[i][k] + B[k][j].
+ *
+ * The product is computed in tiles and the innermost loop runs over
+ * contiguous cells of a row so it's vectorized. Ties are broken in favor of
+ * the lowest k.
+ *
+ * @param a, a n x n matrix.
+ * @param b, a n x n matrix.
+ * @param c, a n x n matrix where the product is stored. Must not be a or b.
+ * @param mid, a n x n matrix where the k of every minimum is stored.
+ * @return nothing
+ */
+void minplus_product(matrix* a, matrix* b, matrix* c, matrix* mid);
+
+/**
+ * Relax a block of rows of C through a block of rows of B:
+ * C[i][j] = min(C[i][j], A[i][k] + B[k][j]) for k in [k0, k1) and
+ * j in [j0, j1), recording k + offset in mid when a cell improves.
+ *
+ * This is the kernel minplus_product() is built on, exposed for blocked
+ * algorithms that work on panels of larger matrices.
+ */
+void minplus_block(float** a, float** b, float** c, float** mid,
+                   int i0, int i1, int k0, int k1, int j0, int j1,
+                   int offset);
+
+#endif
@@ -0,0 +1,367 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "processes.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Nanoseconds between checks of a waiting process, for the others to arrive
+ * and to be alive */
+#define FLOYD_POLL 50000
+
+/**
+ * Shared memory segment header. D and P tables follow, row major.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    int count;
+    int waiting;
+    int phase;
+    bool aborted;
+} floyd_shared;
+
+/**
+ * Processes a waiting one checks are alive: the workers for the first
+ * process, its parent for the others.
+ */
+typedef struct {
+    pid_t* workers;
+    int started;
+    pid_t parent;
+} floyd_peers;
+
+/* Segments of concurrent solves in this process */
+static gint floyd_segments = 0;
+
+/**
+ * Part of the tables owned by one process, in tiles.
+ */
+typedef struct {
+    int first_row;
+    int last_row;
+    int first_column;
+    int last_column;
+} floyd_owner;
+
+static int floyd_split(int tiles, int parts, int part)
+{
+    return (tiles * part) / parts;
+}
+
+static floyd_owner floyd_owner_of(int tiles, int rows, int columns, int rank)
+{
+    floyd_owner o;
+    int row = rank / columns;
+    int column = rank % columns;
+    o.first_row = floyd_split(tiles, rows, row);
+    o.last_row = floyd_split(tiles, rows, row + 1);
+    o.first_column = floyd_split(tiles, columns, column);
+    o.last_column = floyd_split(tiles, columns, column + 1);
+    return o;
+}
+
+static bool floyd_owns(floyd_owner* o, int tile_row, int tile_column)
+{
+    return (tile_row >= o->first_row) && (tile_row < o->last_row) &&
+           (tile_column >= o->first_column) && (tile_column < o->last_column);
+}
+
+/* Relax a tile through every k of a k-block, one k at a time */
+static void floyd_tile(float** d, float** p, int n, int tile_row,
+                       int tile_column, int k_block)
+{
+    int i1 = min((tile_row + 1) * FLOYD_TILE, n);
+    int j1 = min((tile_column + 1) * FLOYD_TILE, n);
+    int k1 = min((k_block + 1) * FLOYD_TILE, n);
+
+    for(int k = k_block * FLOYD_TILE; k < k1; k++) {
+        for(int i = tile_row * FLOYD_TILE; i < i1; i++) {
+            float d_ik = d[i][k];
+            if(d_ik == PLUS_INF) {
+                continue;
+            }
+            for(int j = tile_column * FLOYD_TILE; j < j1; j++) {
+                float minimum = d_ik + d[k][j];
+                if(minimum < d[i][j]) {
+                    p[i][j] = k + 1;
+                    d[i][j] = minimum;
+                }
+            }
+        }
+    }
+}
+
+/* Tell if the peers are alive, workers that ended are left to be collected */
+static bool floyd_alive(floyd_peers* peers)
+{
+    if(peers->workers == NULL) {
+        return getppid() == peers->parent;
+    }
+    bool alive = true;
+    for(int w = 1; w < peers->started; w++) {
+        siginfo_t info;
+        info.si_pid = 0;
+        if((waitid(P_PID, peers->workers[w], &info,
+                   WEXITED | WNOHANG | WNOWAIT) == 0) && (info.si_pid != 0)) {
+            alive = false;
+        }
+    }
+    return alive;
+}
+
+/* Lock the header, a process dying with it held aborts the solve */
+static void floyd_lock(floyd_shared* shared)
+{
+    if(pthread_mutex_lock(&shared->lock) == EOWNERDEAD) {
+        shared->aborted = true;
+        pthread_mutex_consistent(&shared->lock);
+    }
+}
+
+/* Abort the solve, every waiting process returns */
+static void floyd_abort(floyd_shared* shared)
+{
+    floyd_lock(shared);
+    shared->aborted = true;
+    pthread_mutex_unlock(&shared->lock);
+}
+
+/*
+ * Wait for every process, checking every FLOYD_POLL if they arrived and the
+ * peers are still alive. Returns FALSE if the solve was aborted, by a dead
+ * peer or otherwise.
+ *
+ * A process-shared condition variable can't be used: one of its waiters
+ * dying leaves it waiting for that process forever.
+ */
+static bool floyd_barrier(floyd_shared* shared, floyd_peers* peers)
+{
+    floyd_lock(shared);
+    int phase = shared->phase;
+    shared->waiting++;
+    if(shared->waiting == shared->count) {
+        shared->waiting = 0;
+        shared->phase++;
+    }
+    bool waiting = (shared->phase == phase) && !shared->aborted;
+    pthread_mutex_unlock(&shared->lock);
+
+    struct timespec poll = {0, FLOYD_POLL};
+    while(waiting) {
+        nanosleep(&poll, NULL);
+        bool alive = floyd_alive(peers);
+
+        /* A peer that ended after arriving isn't an error */
+        floyd_lock(shared);
+        if(!alive && (shared->phase == phase)) {
+            shared->aborted = true;
+        }
+        waiting = (shared->phase == phase) && !shared->aborted;
+        pthread_mutex_unlock(&shared->lock);
+    }
+
+    floyd_lock(shared);
+    bool aborted = shared->aborted;
+    pthread_mutex_unlock(&shared->lock);
+    return !aborted;
+}
+
+static bool floyd_worker(floyd_shared* shared, floyd_peers* peers,
+                         float** d, float** p, int n, floyd_owner* o)
+{
+    int tiles = (n + FLOYD_TILE - 1) / FLOYD_TILE;
+
+    for(int kb = 0; kb < tiles; kb++) {
+
+        /* Diagonal tile */
+        if(floyd_owns(o, kb, kb)) {
+            floyd_tile(d, p, n, kb, kb, kb);
+        }
+        if(!floyd_barrier(shared, peers)) {
+            return false;
+        }
+
+        /* Row and column panels of this k-block */
+        for(int t = 0; t < tiles; t++) {
+            if((t != kb) && floyd_owns(o, kb, t)) {
+                floyd_tile(d, p, n, kb, t, kb);
+            }
+            if((t != kb) && floyd_owns(o, t, kb)) {
+                floyd_tile(d, p, n, t, kb, kb);
+            }
+        }
+        if(!floyd_barrier(shared, peers)) {
+            return false;
+        }
+
+        /* Everything else, reading the panels other processes published */
+        int k0 = kb * FLOYD_TILE;
+        int k1 = min(k0 + FLOYD_TILE, n);
+        for(int ti = o->first_row; ti < o->last_row; ti++) {
+            if(ti == kb) {
+                continue;
+            }
+            for(int tj = o->first_column; tj < o->last_column; tj++) {
+                if(tj == kb) {
+                    continue;
+                }
+                minplus_block(d, d, d, p,
+                              ti * FLOYD_TILE, min((ti + 1) * FLOYD_TILE, n),
+                              k0, k1,
+                              tj * FLOYD_TILE, min((tj + 1) * FLOYD_TILE, n),
+                              1);
+            }
+        }
+        if(!floyd_barrier(shared, peers)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool floyd_processes(floyd_context* c, int processes)
+{
+    int n = c->nodes;
+
+    /* Most square grid of processes */
+    int rows = 1;
+    for(int r = 1; r * r <= processes; r++) {
+        if(processes % r == 0) {
+            rows = r;
+        }
+    }
+    int columns = processes / rows;
+
+    /* Create and map the shared memory segment */
+    size_t header = (sizeof(floyd_shared) + 63) & ~((size_t)63);
+    size_t table = (size_t)n * n * sizeof(float);
+    size_t size = header + (2 * table);
+
+    /* Unique to this solve, even with others running in this process */
+    char* name = g_strdup_printf("/floyd-%i-%i", (int)getpid(),
+                                 g_atomic_int_add(&floyd_segments, 1));
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if(fd < 0) {
+        g_free(name);
+        return false;
+    }
+    shm_unlink(name);
+    g_free(name);
+    if(ftruncate(fd, size) != 0) {
+        close(fd);
+        return false;
+    }
+    char* segment = (char*) mmap(NULL, size, PROT_READ | PROT_WRITE,
+                                 MAP_SHARED, fd, 0);
+    close(fd);
+    if(segment == MAP_FAILED) {
+        return false;
+    }
+
+    /* Rows of the shared tables */
+    floyd_shared* shared = (floyd_shared*) segment;
+    float* shared_d = (float*) (segment + header);
+    float* shared_p = (float*) (segment + header + table);
+    float** d = (float**) malloc(n * sizeof(float*));
+    float** p = (float**) malloc(n * sizeof(float*));
+    pid_t* workers = (pid_t*) malloc(processes * sizeof(pid_t));
+    if((d == NULL) || (p == NULL) || (workers == NULL)) {
+        free(d);
+        free(p);
+        free(workers);
+        munmap(segment, size);
+        return false;
+    }
+    for(int i = 0; i < n; i++) {
+        d[i] = shared_d + ((size_t)i * n);
+        p[i] = shared_p + ((size_t)i * n);
+        memcpy(d[i], c->table_d->data[i], n * sizeof(float));
+        memcpy(p[i], c->table_p->data[i], n * sizeof(float));
+    }
+
+    pthread_mutexattr_t lock_attributes;
+    pthread_mutexattr_init(&lock_attributes);
+    pthread_mutexattr_setpshared(&lock_attributes, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&lock_attributes, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&shared->lock, &lock_attributes);
+    pthread_mutexattr_destroy(&lock_attributes);
+
+    shared->count = processes;
+    shared->waiting = 0;
+    shared->phase = 0;
+    shared->aborted = false;
+
+    /* Start workers, this process is the first one */
+    int tiles = (n + FLOYD_TILE - 1) / FLOYD_TILE;
+    bool success = true;
+    int started = 1;
+    pid_t parent = getpid();
+    for(; started < processes; started++) {
+        pid_t pid = fork();
+        if(pid < 0) {
+            success = false;
+            break;
+        }
+        if(pid == 0) {
+            floyd_peers peers = {NULL, 0, parent};
+            floyd_owner o = floyd_owner_of(tiles, rows, columns, started);
+            _exit(floyd_worker(shared, &peers, d, p, n, &o) ? 0 : 1);
+        }
+        workers[started] = pid;
+    }
+
+    if(success) {
+        floyd_peers peers = {workers, started, parent};
+        floyd_owner o = floyd_owner_of(tiles, rows, columns, 0);
+        success = floyd_worker(shared, &peers, d, p, n, &o);
+    } else {
+        /* Started workers are waiting at the first barrier */
+        floyd_abort(shared);
+    }
+
+    /* Collect workers */
+    for(int w = 1; w < started; w++) {
+        int status = 0;
+        waitpid(workers[w], &status, 0);
+        if(!WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
+            success = false;
+        }
+    }
+
+    /* Copy back results */
+    if(success) {
+        for(int i = 0; i < n; i++) {
+            memcpy(c->table_d->data[i], d[i], n * sizeof(float));
+            memcpy(c->table_p->data[i], p[i], n * sizeof(float));
+        }
+    }
+
+    pthread_mutex_destroy(&shared->lock);
+    munmap(segment, size);
+    free(d);
+    free(p);
+    free(workers);
+    return success;
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_FLOYD_PROCESSES
+#define H_FLOYD_PROCESSES
+
+#include "floyd.h"
+#include "minplus.h"
+
+/* Size of the square tiles the tables are decomposed in */
+#define FLOYD_TILE 64
+
+/**
+ * Perform Floyd algorithm with several cooperating processes.
+ *
+ * The D and P tables are copied to a POSIX shared memory segment and split
+ * in a 2D grid of tiles, each process owning a rectangle of tiles. For every
+ * k-block the owner of the diagonal tile closes it, the owners of the row and
+ * column panels relax them and publish them in shared memory, and then every
+ * process relaxes the rest of its tiles with the published panels. Processes
+ * synchronize with a barrier in shared memory between phases. While waiting
+ * at it they check their peers are alive, and if one died the solve is
+ * aborted and every process returns.
+ *
+ * @param floyd_context, the floyd's context data structure.
+ * @param processes, the total number of processes, the calling one included.
+ * @return TRUE if execution was successful or FALSE if the shared memory
+ *         couldn't be set up or a worker process failed.
+ */
+bool floyd_processes(floyd_context* c, int processes);
+
+#endif
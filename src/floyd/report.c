@@ -63,15 +63,20 @@ bool floyd_report(floyd_context* c)
 
     /* Write graph */
     fprintf(report, "\\subsection{%s}\n", "Input graph");
-    gv2pdf("graph", "reports");
-    if(file_exists("reports/graph.pdf")) {
-        fprintf(report, "\\begin{figure}[H]\\centering\n");
-        fprintf(report, "\\noindent\\includegraphics[height=210px]"
-                        "{reports/graph.pdf}\n");
-        fprintf(report, "\\caption{%s.}\n\\end{figure}\n",
-                        "Floyd's input directed graph system");
+    if(c->nodes > FLOYD_GRAPH_MAX_NODES) {
+        fprintf(report, "Graph omitted, it has more than %i nodes.\n",
+                        FLOYD_GRAPH_MAX_NODES);
     } else {
-        fprintf(report, "ERROR: Graph image could not be generated.\n");
+        gv2pdf("graph", "reports");
+        if(file_exists("reports/graph.pdf")) {
+            fprintf(report, "\\begin{figure}[H]\\centering\n");
+            fprintf(report, "\\noindent\\includegraphics[height=210px]"
+                            "{reports/graph.pdf}\n");
+            fprintf(report, "\\caption{%s.}\n\\end{figure}\n",
+                            "Floyd's input directed graph system");
+        } else {
+            fprintf(report, "ERROR: Graph image could not be generated.\n");
+        }
     }
     fprintf(report, "\n");
 
@@ -81,6 +86,10 @@ bool floyd_report(floyd_context* c)
 
     /* Write execution */
     fprintf(report, "\\subsection{%s}\n", "Execution");
+    if(c->nodes > FLOYD_LOG_MAX_NODES) {
+        fprintf(report, "Tables omitted, the graph has more than %i nodes.\n",
+                        FLOYD_LOG_MAX_NODES);
+    }
     success = copy_streams(c->report_buffer, report);
     if(!success) {
         return false;
@@ -89,10 +98,10 @@ bool floyd_report(floyd_context* c)
 
     /* Write analisis */
     int bumpier = -1;
-    int startb, endb;
+    int startb = 0, endb = 0;
 
     float heavier = -1.0;
-    int starth, endh;
+    int starth = 0, endh = 0;
 
     fprintf(report, "\\subsection{%s}\n", "Analisis");
     int counter = 0;
@@ -281,9 +290,16 @@ void floyd_table(matrix* m, bool d, int k, FILE* stream)
 }
 
 void floyd_graph(matrix* m, char** n)
+{
+    floyd_graph_as(m, n, "graph");
+}
+
+void floyd_graph_as(matrix* m, char** n, char* name)
 {
     /* Create graph file */
-    FILE* graph = fopen("reports/graph.gv", "w");
+    char* filename = g_strdup_printf("reports/%s.gv", name);
+    FILE* graph = fopen(filename, "w");
+    g_free(filename);
     if(graph == NULL) {
         return;
     }
@@ -295,8 +311,7 @@ void floyd_graph(matrix* m, char** n)
 
     /* Labels */
     for(int i = 0; i < m->rows; i++) {
-        char* name = n[i];
-        fprintf(graph, "    %i [label = \"%s\"];\n", i + 1, name);
+        fprintf(graph, "    %i [label = \"%s\"];\n", i + 1, n[i]);
     }
     fprintf(graph, "\n");
 
@@ -16,8 +16,29 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include "floyd.h"
 #include "latex.h"
+#include <dirent.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <time.h>
+
+#define CHECKPOINT_FILE "reports/floyd.ckpt"
+
+floyd_context* random_graph(int nodes);
+bool same_tables(floyd_context* a, floyd_context* b);
+bool test_checkpoint(int nodes);
+float path_length(floyd_context* c, int* path, int n);
+bool test_lazy(int nodes);
+bool test_hops(int nodes, int hops);
+bool test_processes(int nodes, int processes);
+bool test_concurrent_processes(int nodes, int processes);
+bool test_dead_worker(int nodes, int processes);
+bool test_log();
 
 int main(int argc, char **argv)
 {
@@ -106,5 +127,543 @@ int main(int argc, char **argv)
 
     /* Free resources */
     floyd_context_free(c);
+
+    /* Crash consistency of checkpoints */
+    if(!test_checkpoint(400)) {
+        printf("ERROR: Resumed execution differs from full execution.\n");
+        return(-3);
+    }
+
+    /* Lazy rows */
+    if(!test_lazy(100)) {
+        printf("ERROR: Lazy rows differ from full execution.\n");
+        return(-4);
+    }
+
+    /* Hop-bounded paths */
+    int hops[] = {1, 2, 3, 5, 8, 13, 99};
+    for(int h = 0; h < 7; h++) {
+        if(!test_hops(100, hops[h])) {
+            printf("ERROR: Wrong hop-bounded paths with %i hops.\n", hops[h]);
+            return(-5);
+        }
+    }
+
+    /* Worker processes */
+    for(int w = 2; w <= 6; w++) {
+        if(!test_processes(300, w)) {
+            printf("ERROR: Wrong results with %i processes.\n", w);
+            return(-6);
+        }
+    }
+    if(!test_concurrent_processes(300, 3)) {
+        printf("ERROR: Concurrent solves with processes failed.\n");
+        return(-7);
+    }
+
+    if(!test_dead_worker(1500, 4)) {
+        printf("ERROR: A dead worker process wasn't handled.\n");
+        return(-7);
+    }
+
+    /* Iterations logged for the report */
+    if(!test_log()) {
+        printf("ERROR: Wrong iterations logged for the report.\n");
+        return(-8);
+    }
     return(0);
 }
+
+floyd_context* random_graph(int nodes)
+{
+    floyd_context* c = floyd_context_new(nodes);
+    if(c == NULL) {
+        return NULL;
+    }
+
+    /* Deterministic sparse graph, same for every call */
+    unsigned int seed = 12345;
+    for(int i = 0; i < nodes; i++) {
+        for(int j = 0; j < nodes; j++) {
+            seed = seed * 1103515245 + 12345;
+            if((i != j) && ((seed >> 16) % 100 < 10)) {
+                c->table_d->data[i][j] = (float)(1 + (seed >> 8) % 50);
+            }
+        }
+    }
+    return c;
+}
+
+bool same_tables(floyd_context* a, floyd_context* b)
+{
+    size_t row_size = a->nodes * sizeof(MATRIX_DATATYPE);
+    for(int i = 0; i < a->nodes; i++) {
+        if((memcmp(a->table_d->data[i], b->table_d->data[i], row_size) != 0) ||
+           (memcmp(a->table_p->data[i], b->table_p->data[i], row_size) != 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Tell if a line of the report logged so far contains a text */
+static bool logged_text(floyd_context* c, const char* text)
+{
+    char line[4096];
+    bool found = false;
+    rewind(c->report_buffer);
+    while(!found && (fgets(line, sizeof(line), c->report_buffer) != NULL)) {
+        found = strstr(line, text) != NULL;
+    }
+    fseek(c->report_buffer, 0, SEEK_END);
+    return found;
+}
+
+/* Iterations completed by the checkpoint file, -1 if there is none */
+static int checkpoint_iteration()
+{
+    FILE* f = fopen(CHECKPOINT_FILE, "rb");
+    if(f == NULL) {
+        return -1;
+    }
+    int k = -1;
+    /* After the 8 bytes of magic and the number of nodes */
+    if((fseek(f, 8 + sizeof(int), SEEK_SET) != 0) ||
+       (fread(&k, sizeof(int), 1, f) != 1)) {
+        k = -1;
+    }
+    fclose(f);
+    return k;
+}
+
+bool test_checkpoint(int nodes)
+{
+    printf("Testing Floyd checkpoints with %i nodes...\n", nodes);
+    remove(CHECKPOINT_FILE);
+
+    /* Uninterrupted execution */
+    floyd_context* full = random_graph(nodes);
+    if(full == NULL) {
+        return false;
+    }
+    floyd(full);
+
+    /* Execution killed mid-way, while writing the checkpoint after a random
+     * iteration past the first quarter */
+    int target = nodes / 4 + rand() % (nodes / 2);
+    char* tmp_file = CHECKPOINT_FILE ".tmp";
+    remove(tmp_file);
+    pid_t pid = fork();
+    if(pid < 0) {
+        floyd_context_free(full);
+        return false;
+    }
+    if(pid == 0) {
+        floyd_context* worker = random_graph(nodes);
+        worker->checkpoint_file = CHECKPOINT_FILE;
+        worker->checkpoint_interval = 1;
+        floyd(worker);
+        _exit(0);
+    }
+
+    struct timespec wait = {0, 50000};
+    for(int t = 0; (t < 200000) && (checkpoint_iteration() < target); t++) {
+        nanosleep(&wait, NULL);
+    }
+    for(int t = 0; (t < 200000) && !file_exists(tmp_file); t++) {
+        nanosleep(&wait, NULL);
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+    bool writing = file_exists(tmp_file);
+
+    /* Resume from whatever survived */
+    floyd_context* resumed = random_graph(nodes);
+    resumed->checkpoint_file = CHECKPOINT_FILE;
+    int k = floyd_checkpoint_load(resumed);
+    printf("Worker killed after %i of %i iterations%s.\n", k, nodes,
+           writing ? ", while writing the next checkpoint" : "");
+    bool success = (k >= target) && floyd_resume(resumed) &&
+                   same_tables(full, resumed);
+    remove(tmp_file);
+
+    /* A crash after writing the next checkpoint but before renaming it
+     * resumes from the previous one */
+    if(success) {
+        floyd_context* crashed = random_graph(nodes);
+        crashed->checkpoint_file = tmp_file;
+        floyd_checkpoint(resumed, nodes);
+        success = floyd_checkpoint(crashed, 0) &&
+                  (floyd_checkpoint_load(crashed) == 0);
+        crashed->checkpoint_file = CHECKPOINT_FILE;
+        success = success && (floyd_checkpoint_load(crashed) == nodes) &&
+                  same_tables(full, crashed);
+        floyd_context_free(crashed);
+        remove(tmp_file);
+    }
+
+    /* Its report says where it was resumed */
+    char note[64];
+    snprintf(note, sizeof(note), "Resumed at iteration %i ", k);
+    success = success && logged_text(resumed, note);
+
+    /* A corrupted checkpoint must be rejected */
+    if(success) {
+        floyd_checkpoint(resumed, nodes);
+        FILE* f = fopen(CHECKPOINT_FILE, "r+b");
+        fseek(f, -10, SEEK_END);
+        int byte = fgetc(f);
+        fseek(f, -10, SEEK_END);
+        fputc(~byte, f);
+        fclose(f);
+        success = (floyd_checkpoint_load(resumed) == -1) &&
+                  same_tables(full, resumed);
+    }
+
+    /* A checkpoint that can't be written is reported, the run completes */
+    if(success) {
+        floyd_context* unwritable = random_graph(nodes);
+        unwritable->checkpoint_file = "reports/missing/floyd.ckpt";
+        unwritable->checkpoint_interval = nodes / 2;
+        success = floyd(unwritable) &&
+                  (unwritable->status == FLOYD_CHECKPOINT_FAILED) &&
+                  same_tables(full, unwritable) &&
+                  (full->status == FLOYD_SUCCESS);
+        floyd_context_free(unwritable);
+    }
+
+    /* A short checkpoint must be rejected too, tables left untouched */
+    if(success) {
+        floyd_checkpoint(resumed, nodes);
+        FILE* f = fopen(CHECKPOINT_FILE, "rb");
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        fclose(f);
+        success = (truncate(CHECKPOINT_FILE, size / 2) == 0) &&
+                  (floyd_checkpoint_load(resumed) == -1) &&
+                  same_tables(full, resumed);
+    }
+
+    remove(CHECKPOINT_FILE);
+    floyd_context_free(full);
+    floyd_context_free(resumed);
+    return success;
+}
+
+float path_length(floyd_context* c, int* path, int n)
+{
+    float length = 0.0;
+    for(int i = 1; i < n; i++) {
+        length += c->table_d->data[path[i - 1]][path[i]];
+    }
+    return length;
+}
+
+bool test_lazy(int nodes)
+{
+    printf("Testing lazy Floyd rows with %i nodes...\n", nodes);
+
+    floyd_context* full = random_graph(nodes);
+    floyd_context* input = random_graph(nodes);
+
+    /* Room for only a few rows to exercise evictions */
+    size_t row_size = nodes * (sizeof(float) + sizeof(int));
+    floyd_lazy_context* l = floyd_lazy_context_new(input, 8 * row_size);
+    if((full == NULL) || (input == NULL) || (l == NULL)) {
+        return false;
+    }
+    floyd(full);
+
+    int* path = (int*) malloc(nodes * sizeof(int));
+    int* lazy_path = (int*) malloc(nodes * sizeof(int));
+    bool success = true;
+    for(int q = 0; (q < 20 * nodes) && success; q++) {
+        int from = (q * 7) % 13 + (q % 3) * (nodes / 3);
+        int to = (q * 31) % nodes;
+
+        float distance = floyd_distance(full, from, to);
+        success = (floyd_lazy_distance(l, from, to) == distance) &&
+                  (l->status == FLOYD_SUCCESS);
+
+        int n = floyd_path(full, from, to, path);
+        int m = floyd_lazy_path(l, from, to, lazy_path);
+        if(distance == PLUS_INF) {
+            success &= (n == 0) && (m == 0);
+        } else {
+            success &= (path[0] == from) && (path[n - 1] == to) &&
+                       (lazy_path[0] == from) && (lazy_path[m - 1] == to) &&
+                       (path_length(input, path, n) == distance) &&
+                       (path_length(input, lazy_path, m) == distance);
+        }
+    }
+    printf("Cached %i rows: %i hits, %i misses.\n",
+           l->cached_rows, l->hits, l->misses);
+
+    free(path);
+    free(lazy_path);
+    floyd_lazy_context_free(l);
+    floyd_context_free(full);
+    floyd_context_free(input);
+    return success;
+}
+
+bool test_hops(int nodes, int hops)
+{
+    printf("Testing hop-bounded paths with %i nodes and %i hops...\n",
+           nodes, hops);
+
+    floyd_context* input = random_graph(nodes);
+    floyd_hops_context* h = floyd_hops_context_new(input, hops);
+    matrix* expected = matrix_new(nodes, nodes, PLUS_INF);
+    matrix* next = matrix_new(nodes, nodes, PLUS_INF);
+    if((input == NULL) || (h == NULL) || (expected == NULL) || (next == NULL)) {
+        return false;
+    }
+    if(!floyd_hops(h)) {
+        return false;
+    }
+
+    /* Solving again starts over instead of stacking more products */
+    int steps = h->steps;
+    if(!floyd_hops(h) || (h->steps != steps)) {
+        return false;
+    }
+
+    /* Reference, extend paths one edge at a time */
+    matrix* a = input->table_d;
+    for(int i = 0; i < nodes; i++) {
+        expected->data[i][i] = 0.0;
+    }
+    for(int s = 0; s < hops; s++) {
+        matrix_copy(expected, next);
+        for(int i = 0; i < nodes; i++) {
+            for(int k = 0; k < nodes; k++) {
+                if(expected->data[i][k] == PLUS_INF) {
+                    continue;
+                }
+                for(int j = 0; j < nodes; j++) {
+                    float d = expected->data[i][k] + a->data[k][j];
+                    if(d < next->data[i][j]) {
+                        next->data[i][j] = d;
+                    }
+                }
+            }
+        }
+        matrix_copy(next, expected);
+    }
+
+    int* path = (int*) malloc((hops + 1) * sizeof(int));
+    bool success = true;
+    for(int i = 0; (i < nodes) && success; i++) {
+        for(int j = 0; (j < nodes) && success; j++) {
+            float distance = floyd_hops_distance(h, i, j);
+            success = distance == expected->data[i][j];
+
+            int n = floyd_hops_path(h, i, j, path);
+            if(distance == PLUS_INF) {
+                success &= n == 0;
+            } else if(i != j) {
+                success &= (n >= 2) && (n <= hops + 1) &&
+                           (path[0] == i) && (path[n - 1] == j) &&
+                           (path_length(input, path, n) == distance);
+            }
+        }
+    }
+
+    free(path);
+    matrix_free(expected);
+    matrix_free(next);
+    floyd_hops_context_free(h);
+    floyd_context_free(input);
+    return success;
+}
+
+bool test_processes(int nodes, int processes)
+{
+    printf("Testing Floyd with %i nodes and %i processes...\n",
+           nodes, processes);
+
+    floyd_context* c = random_graph(nodes);
+    floyd_context* input = random_graph(nodes);
+    floyd_lazy_context* l = floyd_lazy_context_new(input, 0);
+    if((c == NULL) || (input == NULL) || (l == NULL)) {
+        return false;
+    }
+    c->processes = processes;
+    if(!floyd(c)) {
+        return false;
+    }
+
+    /* Compare against single-source searches */
+    int* path = (int*) malloc(nodes * sizeof(int));
+    bool success = true;
+    for(int i = 0; (i < nodes) && success; i++) {
+        for(int j = 0; (j < nodes) && success; j++) {
+            float distance = floyd_distance(c, i, j);
+            success = distance == floyd_lazy_distance(l, i, j);
+            int n = floyd_path(c, i, j, path);
+            if((distance != PLUS_INF) && (i != j)) {
+                success &= (path[0] == i) && (path[n - 1] == j) &&
+                           (path_length(input, path, n) == distance);
+            }
+        }
+    }
+    printf("Execution time: %lf seconds.\n", c->execution_time);
+
+    free(path);
+    floyd_lazy_context_free(l);
+    floyd_context_free(c);
+    floyd_context_free(input);
+    return success;
+}
+
+/* A child process of this one, 0 if there is none */
+static pid_t find_child()
+{
+    DIR* proc = opendir("/proc");
+    if(proc == NULL) {
+        return 0;
+    }
+    pid_t child = 0;
+    struct dirent* entry;
+    while((child == 0) && ((entry = readdir(proc)) != NULL)) {
+        char* stat = g_strdup_printf("/proc/%s/stat", entry->d_name);
+        FILE* f = fopen(stat, "r");
+        g_free(stat);
+        if(f == NULL) {
+            continue;
+        }
+        int pid = 0;
+        int parent = 0;
+        if((fscanf(f, "%i %*s %*c %i", &pid, &parent) == 2) &&
+           (parent == getpid())) {
+            child = pid;
+        }
+        fclose(f);
+    }
+    closedir(proc);
+    return child;
+}
+
+static gpointer solve_graph(gpointer data)
+{
+    floyd_context* c = (floyd_context*) data;
+    return GINT_TO_POINTER(floyd_processes(c, c->processes));
+}
+
+bool test_concurrent_processes(int nodes, int processes)
+{
+    printf("Testing two concurrent solves with %i processes each...\n",
+           processes);
+
+    floyd_context* expected = random_graph(nodes);
+    floyd_context* a = random_graph(nodes);
+    floyd_context* b = random_graph(nodes);
+    if((expected == NULL) || (a == NULL) || (b == NULL) || !floyd(expected)) {
+        return false;
+    }
+    a->processes = processes;
+    b->processes = processes;
+
+    /* Both solves need their own shared memory segment */
+    GThread* other = g_thread_new("floyd", solve_graph, b);
+    bool success = floyd_processes(a, a->processes);
+    success &= GPOINTER_TO_INT(g_thread_join(other)) != 0;
+
+    size_t row_size = nodes * sizeof(MATRIX_DATATYPE);
+    for(int i = 0; (i < nodes) && success; i++) {
+        success =
+            (memcmp(expected->table_d->data[i], a->table_d->data[i],
+                    row_size) == 0) &&
+            (memcmp(expected->table_d->data[i], b->table_d->data[i],
+                    row_size) == 0);
+    }
+
+    floyd_context_free(expected);
+    floyd_context_free(a);
+    floyd_context_free(b);
+    return success;
+}
+
+/* Bytes logged for the report by a solve of a graph */
+static long logged(int nodes, bool log_iterations, bool checkpoints)
+{
+    floyd_context* c = random_graph(nodes);
+    if(c == NULL) {
+        return -1;
+    }
+    c->log_iterations = log_iterations;
+    if(checkpoints) {
+        c->checkpoint_file = CHECKPOINT_FILE;
+        c->checkpoint_interval = nodes / 4;
+    }
+    floyd(c);
+    long size = ftell(c->report_buffer);
+    floyd_context_free(c);
+    remove(CHECKPOINT_FILE);
+    return size;
+}
+
+bool test_log()
+{
+    printf("Testing iterations logged for the report...\n");
+
+    /* Every iteration, or only the final tables, or nothing at all */
+    long every = logged(50, true, false);
+    long final = logged(50, false, false);
+    bool success = (final > 0) && (every > 40 * final) &&
+                   (logged(50, true, true) == final);
+
+    /* Neither tables nor graph for large graphs */
+    remove("reports/graph.gv");
+    return success && (logged(FLOYD_LOG_MAX_NODES + 1, true, false) == 0) &&
+           !file_exists("reports/graph.gv");
+}
+
+bool test_dead_worker(int nodes, int processes)
+{
+    printf("Testing a worker process killed with %i processes...\n",
+           processes);
+
+    floyd_context* c = random_graph(nodes);
+    if(c == NULL) {
+        return false;
+    }
+    c->processes = processes;
+
+    /* Kill a worker as soon as there is one */
+    GThread* solver = g_thread_new("floyd", solve_graph, c);
+    pid_t worker = 0;
+    struct timespec wait = {0, 1000000};
+    for(int t = 0; (t < 10000) && (worker == 0); t++) {
+        nanosleep(&wait, NULL);
+        worker = find_child();
+    }
+    if(worker != 0) {
+        kill(worker, SIGKILL);
+    }
+    bool success = (worker != 0) &&
+                   (GPOINTER_TO_INT(g_thread_join(solver)) == 0);
+    if(worker == 0) {
+        g_thread_join(solver);
+    }
+
+    /* Every worker was collected */
+    success = success && (waitpid(-1, NULL, WNOHANG) == -1) &&
+              (errno == ECHILD);
+
+    /* And no shared memory segment of this process is left */
+    char* prefix = g_strdup_printf("floyd-%i-", (int)getpid());
+    DIR* shm = opendir("/dev/shm");
+    struct dirent* entry;
+    while(success && (shm != NULL) && ((entry = readdir(shm)) != NULL)) {
+        success = strncmp(entry->d_name, prefix, strlen(prefix)) != 0;
+    }
+    if(shm != NULL) {
+        closedir(shm);
+    }
+    g_free(prefix);
+
+    floyd_context_free(c);
+    return success;
+}
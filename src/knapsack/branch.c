@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "branch.h"
+#include <limits.h>
+
+/**
+ * Item as searched, in decreasing value per weight.
+ */
+typedef struct {
+    int item;
+    int units;
+    double weight;
+    double value;
+} knapsack_branch_item;
+
+static int knapsack_branch_compare(const void* a, const void* b)
+{
+    const knapsack_branch_item* x = (const knapsack_branch_item*) a;
+    const knapsack_branch_item* y = (const knapsack_branch_item*) b;
+
+    /* x before y if x.value / x.weight > y.value / y.weight */
+    double left = x->value * y->weight;
+    double right = y->value * x->weight;
+    if(left != right) {
+        return (left > right) ? -1 : 1;
+    }
+    return x->item - y->item;
+}
+
+/* Best value of items [k, n) in the capacity left, with fractions */
+static double knapsack_branch_bound(knapsack_branch_item* order, int n,
+                                    double* weights, double* values,
+                                    int k, double left)
+{
+    /* Last m with all units of [k, m) fitting */
+    int low = k;
+    int high = n;
+    while(low < high) {
+        int middle = (low + high + 1) / 2;
+        if(weights[middle] - weights[k] <= left) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+
+    double bound = values[low] - values[k];
+    if(low < n) {
+        double rest = left - (weights[low] - weights[k]);
+        bound += rest * order[low].value / order[low].weight;
+    }
+    return bound;
+}
+
+bool knapsack_branch(knapsack_context* c)
+{
+    /* Start counting time */
+    GTimer* timer = g_timer_new();
+
+    knapsack_branch_item* order = (knapsack_branch_item*) malloc(
+                            c->num_items * sizeof(knapsack_branch_item));
+    int* counts = (int*) malloc(c->num_items * sizeof(int));
+    int* best = (int*) malloc(c->num_items * sizeof(int));
+    double* weights = (double*) malloc((c->num_items + 1) * sizeof(double));
+    double* values = (double*) malloc((c->num_items + 1) * sizeof(double));
+    if((order == NULL) || (counts == NULL) || (best == NULL) ||
+       (weights == NULL) || (values == NULL)) {
+        free(order);
+        free(counts);
+        free(best);
+        free(weights);
+        free(values);
+        g_timer_destroy(timer);
+        return false;
+    }
+
+    /* Items worth something, weightless ones are always put whole */
+    int n = 0;
+    double fixed = 0.0;
+    for(int j = 0; j < c->num_items; j++) {
+        item* it = c->items[j];
+        c->solution[j] = 0;
+        if((it->value <= 0.0) || (it->amount < 1.0)) {
+            continue;
+        }
+        if(it->weight <= 0.0) {
+            if(it->amount >= (float)INT_MAX) {
+                free(order);
+                free(counts);
+                free(best);
+                free(weights);
+                free(values);
+                g_timer_destroy(timer);
+                return false;
+            }
+            c->solution[j] = (int)it->amount;
+            fixed += c->solution[j] * (double)it->value;
+            continue;
+        }
+        double fit = floor((double)c->capacity / it->weight);
+        if(fit < 1.0) {
+            continue;
+        }
+        order[n].item = j;
+        order[n].units = (it->amount < fit) ? (int)it->amount : (int)fit;
+        order[n].weight = it->weight;
+        order[n].value = it->value;
+        n++;
+    }
+    qsort(order, n, sizeof(knapsack_branch_item), knapsack_branch_compare);
+
+    /* Prefix sums of every unit, for the bounds */
+    weights[0] = 0.0;
+    values[0] = 0.0;
+    for(int k = 0; k < n; k++) {
+        weights[k + 1] = weights[k] + order[k].units * order[k].weight;
+        values[k + 1] = values[k] + order[k].units * order[k].value;
+    }
+
+    /* Depth first, most units first, without recursion */
+    double best_value = -1.0;
+    double weight = 0.0;
+    double value = 0.0;
+    int k = 0;
+    while(true) {
+
+        /* Descend greedily to a leaf */
+        for(; k < n; k++) {
+            double left = (double)c->capacity - weight;
+            int fit = (int)floor(left / order[k].weight);
+            counts[k] = (fit < order[k].units) ? fit : order[k].units;
+            weight += counts[k] * order[k].weight;
+            value += counts[k] * order[k].value;
+        }
+        if(value > best_value) {
+            best_value = value;
+            memcpy(best, counts, n * sizeof(int));
+        }
+
+        /* Back to the deepest item that can put one unit less */
+        bool found = false;
+        while(!found && (k > 0)) {
+            k--;
+            while(counts[k] > 0) {
+                counts[k]--;
+                weight -= order[k].weight;
+                value -= order[k].value;
+
+                /* Less of a better item only lowers the bound */
+                double left = (double)c->capacity - weight;
+                double bound = value + knapsack_branch_bound(
+                                    order, n, weights, values, k + 1, left);
+                if(bound > best_value) {
+                    found = true;
+                    break;
+                }
+                weight -= counts[k] * order[k].weight;
+                value -= counts[k] * order[k].value;
+                counts[k] = 0;
+            }
+        }
+        if(!found) {
+            break;
+        }
+        k++;
+    }
+
+    for(int i = 0; i < n; i++) {
+        c->solution[order[i].item] = best[i];
+    }
+    c->total_value = (float)(fixed + best_value);
+    c->memory_required += (c->num_items * sizeof(knapsack_branch_item)) +
+                          (2 * c->num_items * sizeof(int)) +
+                          (2 * (c->num_items + 1) * sizeof(double));
+
+    free(order);
+    free(counts);
+    free(best);
+    free(weights);
+    free(values);
+
+    /* Stop counting time */
+    g_timer_stop(timer);
+    c->execution_time = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+    return true;
+}
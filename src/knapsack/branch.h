@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_KNAPSACK_BRANCH
+#define H_KNAPSACK_BRANCH
+
+#include "knapsack.h"
+
+/**
+ * Perform Knapsack algorithm by branch and bound.
+ *
+ * Items are sorted by value per weight and searched depth first, trying the
+ * most units of an item first, so the first leaf is the greedy solution. A
+ * branch is pruned when its fractional (Dantzig) bound, filling the capacity
+ * left with the next items in order and a fraction of the first one not
+ * fitting, is not above the best solution found. The bound is found by
+ * binary search on prefix sums of the items. Instances with a small gap
+ * between the greedy solution and the bound finish almost at once, but the
+ * search is exponential in the worst case.
+ *
+ * knapsack() uses it when the tables didn't fit in KNAPSACK_TABLES_BUDGET.
+ * Only 'solution' and 'total_value' are filled, weights are not rounded.
+ *
+ * @param knapsack_context, the knapsack's context data structure.
+ * @return TRUE if execution was successful or FALSE if an unbounded amount of
+ *         an item without weight is worth something, or memory ran out.
+ */
+bool knapsack_branch(knapsack_context* c);
+
+#endif
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "decisions.h"
+
+/* Bit where a column of 'width' goes after one ending at 'end' */
+static int knapsack_decisions_place(int end, int width)
+{
+    if((end % 64) + width > 64) {
+        return ((end / 64) + 1) * 64;
+    }
+    return end;
+}
+
+knapsack_decisions* knapsack_decisions_new(int rows, int columns,
+                                           int* widths)
+{
+    /* Check input is correct */
+    if((rows < 1) || (columns < 1)) {
+        return NULL;
+    }
+    for(int j = 0; j < columns; j++) {
+        if((widths[j] < 0) || (widths[j] > KNAPSACK_DECISIONS_WIDTH)) {
+            return NULL;
+        }
+    }
+
+    /* Allocate structure */
+    knapsack_decisions* d = (knapsack_decisions*) malloc(
+                                                sizeof(knapsack_decisions));
+    if(d == NULL) {
+        return NULL;
+    }
+    d->widths = (int*) malloc(columns * sizeof(int));
+    d->offsets = (int*) malloc(columns * sizeof(int));
+    if((d->widths == NULL) || (d->offsets == NULL)) {
+        free(d->widths);
+        free(d->offsets);
+        free(d);
+        return NULL;
+    }
+
+    /* Lay out the columns */
+    int end = 0;
+    for(int j = 0; j < columns; j++) {
+        d->widths[j] = widths[j];
+        d->offsets[j] = knapsack_decisions_place(end, widths[j]);
+        end = d->offsets[j] + widths[j];
+    }
+
+    d->rows = rows;
+    d->columns = columns;
+    d->size = columns;
+    d->words = (end + 63) / 64;
+    if(d->words < 1) {
+        d->words = 1;
+    }
+    d->data = (uint64_t*) calloc((size_t)rows * d->words, sizeof(uint64_t));
+    if(d->data == NULL) {
+        free(d->widths);
+        free(d->offsets);
+        free(d);
+        return NULL;
+    }
+    return d;
+}
+
+int knapsack_decisions_width(double units)
+{
+    int width = 0;
+    while((width < KNAPSACK_DECISIONS_WIDTH) &&
+          (units >= (double)((int64_t)1 << width))) {
+        width++;
+    }
+    return width;
+}
+
+bool knapsack_decisions_append(knapsack_decisions* d, int width)
+{
+    if((width < 0) || (width > KNAPSACK_DECISIONS_WIDTH)) {
+        return false;
+    }
+
+    /* Room for the column's layout */
+    if(d->columns == d->size) {
+        int size = d->size * 2;
+        int* widths = (int*) realloc(d->widths, size * sizeof(int));
+        if(widths == NULL) {
+            return false;
+        }
+        d->widths = widths;
+        int* offsets = (int*) realloc(d->offsets, size * sizeof(int));
+        if(offsets == NULL) {
+            return false;
+        }
+        d->offsets = offsets;
+        d->size = size;
+    }
+
+    int end = 0;
+    if(d->columns > 0) {
+        end = d->offsets[d->columns - 1] + d->widths[d->columns - 1];
+    }
+    int offset = knapsack_decisions_place(end, width);
+
+    /* Widen the rows, moving them from the last one down */
+    int needed = (offset + width + 63) / 64;
+    if(needed > d->words) {
+        int words = d->words * 2;
+        if(words < needed) {
+            words = needed;
+        }
+        uint64_t* data = (uint64_t*) realloc(d->data,
+                            (size_t)d->rows * words * sizeof(uint64_t));
+        if(data == NULL) {
+            return false;
+        }
+        for(int i = d->rows - 1; i >= 0; i--) {
+            uint64_t* row = data + ((size_t)i * words);
+            memmove(row, data + ((size_t)i * d->words),
+                    d->words * sizeof(uint64_t));
+            memset(row + d->words, 0, (words - d->words) * sizeof(uint64_t));
+        }
+        d->data = data;
+        d->words = words;
+    }
+
+    d->widths[d->columns] = width;
+    d->offsets[d->columns] = offset;
+    d->columns++;
+    return true;
+}
+
+void knapsack_decisions_print(knapsack_decisions* d)
+{
+    printf("Table: %i x %i\n", d->rows, d->columns);
+    for(int i = 0; i < d->rows; i++) {
+        for(int j = 0; j < d->columns; j++) {
+            printf("%4.2f ", (float)knapsack_decision(d, i, j));
+        }
+        printf("\n");
+    }
+}
+
+unsigned int knapsack_decisions_sizeof(knapsack_decisions* d)
+{
+    return sizeof(knapsack_decisions) + (2 * d->size * sizeof(int)) +
+           ((size_t)d->rows * d->words * sizeof(uint64_t));
+}
+
+void knapsack_decisions_free(knapsack_decisions* d)
+{
+    if(d != NULL) {
+        free(d->widths);
+        free(d->offsets);
+        free(d->data);
+        free(d);
+    }
+    return;
+}
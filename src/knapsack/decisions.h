@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_KNAPSACK_DECISIONS
+#define H_KNAPSACK_DECISIONS
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Widest amount stored, the counts of an int */
+#define KNAPSACK_DECISIONS_WIDTH 31
+
+/**
+ * Amount of each item put at each capacity, packed in as many bits as the
+ * item's column needs. A row holds every column, in 64 bit words so threads
+ * filling different rows never share one, and a column never crosses a word
+ * so reading it is a shift and a mask.
+ */
+typedef struct {
+    int rows;
+    int columns;
+    int words;      /* Per row */
+    int size;       /* Columns with room in 'widths' and 'offsets' */
+    int* widths;
+    int* offsets;   /* Bit of each column in its row */
+    uint64_t* data;
+} knapsack_decisions;
+
+/**
+ * Create the decisions of a table, all zero.
+ *
+ * @param rows, the rows of the table.
+ * @param columns, the columns of the table.
+ * @param widths, the bits of each column, see knapsack_decisions_width().
+ * @return a new decisions structure or NULL if out of range or memory.
+ */
+knapsack_decisions* knapsack_decisions_new(int rows, int columns,
+                                           int* widths);
+
+/**
+ * Bits needed to store any amount up to 'units'.
+ */
+int knapsack_decisions_width(double units);
+
+/**
+ * Add a column at the end. Rows are widened to twice their words when the
+ * column doesn't fit, so appending is amortized O(rows).
+ *
+ * @return FALSE if memory ran out, in which case the decisions are unchanged.
+ */
+bool knapsack_decisions_append(knapsack_decisions* d, int width);
+
+/**
+ * Print the decisions to the standard output, as matrix_print().
+ */
+void knapsack_decisions_print(knapsack_decisions* d);
+
+unsigned int knapsack_decisions_sizeof(knapsack_decisions* d);
+
+void knapsack_decisions_free(knapsack_decisions* d);
+
+/**
+ * Amount put of item 'j' at capacity 'i'.
+ */
+static inline int knapsack_decision(knapsack_decisions* d, int i, int j)
+{
+    int offset = d->offsets[j];
+    uint64_t word = d->data[((size_t)i * d->words) + (offset / 64)];
+    uint64_t mask = ((uint64_t)1 << d->widths[j]) - 1;
+    return (int)((word >> (offset % 64)) & mask);
+}
+
+/**
+ * Store the amount put of item 'j' at capacity 'i', it must fit in the width
+ * of the column.
+ */
+static inline void knapsack_decide(knapsack_decisions* d, int i, int j,
+                                   int taken)
+{
+    int offset = d->offsets[j];
+    uint64_t* word = &d->data[((size_t)i * d->words) + (offset / 64)];
+    uint64_t mask = (((uint64_t)1 << d->widths[j]) - 1) << (offset % 64);
+    *word = (*word & ~mask) | (((uint64_t)taken << (offset % 64)) & mask);
+}
+
+#endif
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fptas.h"
+#include <stdint.h>
+
+bool knapsack_fptas(knapsack_context* c, float epsilon)
+{
+    if((epsilon <= 0.0) || (epsilon >= 1.0)) {
+        return false;
+    }
+
+    /* Start counting time */
+    GTimer* timer = g_timer_new();
+
+    knapsack_bundle* bundles = NULL;
+    int steps = knapsack_bundles(c, &bundles);
+    if(steps < 0) {
+        g_timer_destroy(timer);
+        return false;
+    }
+    for(int j = 0; j < c->num_items; j++) {
+        c->solution[j] = 0;
+    }
+    c->total_value = 0.0;
+    if(steps == 0) {
+        free(bundles);
+        g_timer_destroy(timer);
+        return true;
+    }
+
+    /* Scale values so rounding loses at most epsilon of the best bundle */
+    double most = 0.0;
+    for(int s = 0; s < steps; s++) {
+        double value = bundles[s].units *
+                       (double)c->items[bundles[s].item]->value;
+        most = fmax(most, value);
+    }
+    double factor = epsilon * most / steps;
+    int* scaled = (int*) malloc(steps * sizeof(int));
+    if(scaled == NULL) {
+        free(bundles);
+        g_timer_destroy(timer);
+        return false;
+    }
+    long top = 0;
+    for(int s = 0; s < steps; s++) {
+        scaled[s] = (int)floor(bundles[s].units *
+                               (double)c->items[bundles[s].item]->value /
+                               factor);
+        top += scaled[s];
+    }
+
+    /* Least weight reaching each scaled value, and a bit per choice */
+    long words = (top / 64) + 1;
+    double* least = (double*) malloc((top + 1) * sizeof(double));
+    uint64_t* taken = (uint64_t*) calloc((size_t)steps * words,
+                                         sizeof(uint64_t));
+    if((least == NULL) || (taken == NULL)) {
+        free(least);
+        free(taken);
+        free(scaled);
+        free(bundles);
+        g_timer_destroy(timer);
+        return false;
+    }
+    least[0] = 0.0;
+    for(long v = 1; v <= top; v++) {
+        least[v] = HUGE_VAL;
+    }
+
+    long reached = 0;
+    for(int s = 0; s < steps; s++) {
+        double weight = bundles[s].units *
+                        (double)c->items[bundles[s].item]->weight;
+        uint64_t* bits = taken + ((size_t)s * words);
+        reached += scaled[s];
+
+        /* Downwards, so lower values still exclude this bundle */
+        for(long v = reached; v >= scaled[s]; v--) {
+            double candidate = least[v - scaled[s]] + weight;
+            if(candidate < least[v]) {
+                least[v] = candidate;
+                bits[v / 64] |= (uint64_t)1 << (v % 64);
+            }
+        }
+    }
+
+    /* Highest scaled value that fits, walk back its bundles */
+    long v = top;
+    while(least[v] > (double)c->capacity) {
+        v--;
+    }
+    double total = 0.0;
+    for(int s = steps - 1; s > -1; s--) {
+        uint64_t* bits = taken + ((size_t)s * words);
+        if((bits[v / 64] >> (v % 64)) & 1) {
+            item* it = c->items[bundles[s].item];
+            c->solution[bundles[s].item] += bundles[s].units;
+            total += bundles[s].units * (double)it->value;
+            v -= scaled[s];
+        }
+    }
+    c->total_value = (float)total;
+    c->memory_required += ((top + 1) * sizeof(double)) +
+                          (steps * words * sizeof(uint64_t)) +
+                          (steps * (sizeof(int) + sizeof(knapsack_bundle)));
+
+    free(least);
+    free(taken);
+    free(scaled);
+    free(bundles);
+
+    /* Stop counting time */
+    g_timer_stop(timer);
+    c->execution_time = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+    return true;
+}
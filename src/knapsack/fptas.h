@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_KNAPSACK_FPTAS
+#define H_KNAPSACK_FPTAS
+
+#include "knapsack.h"
+
+/**
+ * Perform an approximate Knapsack algorithm, within a chosen error.
+ *
+ * Items are split in bundles as knapsack_pareto() does. With B bundles and
+ * the most valuable one worth V, values are scaled down by K = epsilon x V / B
+ * and rounded down, and the least weight reaching every scaled value is found
+ * by dynamic programming. Rounding loses less than K per bundle, so the
+ * selection is worth at least (1 - epsilon) times the optimum. Time and
+ * memory are O(B^3 / epsilon), independent of the capacity and of the value
+ * range.
+ *
+ * Only 'solution' and 'total_value' are filled, so the context can be created
+ * with knapsack_context_new_compact().
+ *
+ * @param knapsack_context, the knapsack's context data structure.
+ * @param epsilon, the relative error allowed, between 0 and 1.
+ * @return TRUE if execution was successful or FALSE if epsilon is out of
+ *         range, an item has no weight or memory ran out.
+ */
+bool knapsack_fptas(knapsack_context* c, float epsilon);
+
+#endif
@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "groups.h"
+#include <pthread.h>
+
+/**
+ * Groups after dropping dominated items, shared by the worker threads.
+ */
+typedef struct {
+    int count;
+    int* starts;        /* First member of each group, and past the last */
+    int* members;       /* Items kept, by group and increasing weight */
+    int* weights;       /* Of each member, in whole units */
+    int rows;
+    float* layers[2];
+    knapsack_decisions* picks;
+    pthread_barrier_t barrier;
+} knapsack_choice;
+
+/**
+ * Data of each worker thread.
+ */
+typedef struct {
+    knapsack_choice* g;
+    knapsack_context* c;
+    int rank;
+    int threads;
+} knapsack_choice_worker;
+
+/**
+ * Item as sorted in its group.
+ */
+typedef struct {
+    int item;
+    int group;
+    int weight;
+    float value;
+} knapsack_member;
+
+/* By group, then lighter first, then more valuable first */
+static int knapsack_member_compare(const void* a, const void* b)
+{
+    const knapsack_member* x = (const knapsack_member*) a;
+    const knapsack_member* y = (const knapsack_member*) b;
+    if(x->group != y->group) {
+        return (x->group < y->group) ? -1 : 1;
+    }
+    if(x->weight != y->weight) {
+        return (x->weight < y->weight) ? -1 : 1;
+    }
+    if(x->value != y->value) {
+        return (x->value > y->value) ? -1 : 1;
+    }
+    return x->item - y->item;
+}
+
+bool knapsack_is_grouped(knapsack_context* c)
+{
+    for(int j = 0; j < c->num_items; j++) {
+        if(c->items[j]->group >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Sort the items in groups and drop the dominated ones */
+static bool knapsack_choice_filter(knapsack_context* c, knapsack_choice* g)
+{
+    int n = c->num_items;
+    knapsack_member* sorted = (knapsack_member*) malloc(
+                                            n * sizeof(knapsack_member));
+    g->members = (int*) malloc(n * sizeof(int));
+    g->weights = (int*) malloc(n * sizeof(int));
+    g->starts = (int*) malloc((n + 1) * sizeof(int));
+    if((sorted == NULL) || (g->members == NULL) || (g->weights == NULL) ||
+       (g->starts == NULL)) {
+        free(sorted);
+        return false;
+    }
+    for(int j = 0; j < n; j++) {
+        item* it = c->items[j];
+        if((it->group < 0) || (it->weight < 0.0)) {
+            free(sorted);
+            return false;
+        }
+        sorted[j].item = j;
+        sorted[j].group = it->group;
+        sorted[j].weight = (ceilf(it->weight) > c->capacity) ?
+                           c->capacity + 1 : (int)ceilf(it->weight);
+        sorted[j].value = it->value;
+    }
+    qsort(sorted, n, sizeof(knapsack_member), knapsack_member_compare);
+
+    /* Keep an item if it is worth more than every lighter one of its group */
+    int kept = 0;
+    g->count = 0;
+    bool empty = false;
+    for(int k = 0; k < n; k++) {
+        knapsack_member* m = &sorted[k];
+        if((k == 0) || (sorted[k - 1].group != m->group)) {
+            empty = empty || ((g->count > 0) &&
+                              (g->starts[g->count - 1] == kept));
+            g->starts[g->count++] = kept;
+        }
+        if((m->weight > c->capacity) ||
+           ((kept > g->starts[g->count - 1]) &&
+            (m->value <= c->items[g->members[kept - 1]]->value))) {
+            continue;
+        }
+        g->members[kept] = m->item;
+        g->weights[kept] = m->weight;
+        kept++;
+    }
+    empty = empty || (g->count == 0) || (g->starts[g->count - 1] == kept);
+    g->starts[g->count] = kept;
+
+    free(sorted);
+    return !empty;
+}
+
+static gpointer knapsack_choice_work(gpointer data)
+{
+    knapsack_choice_worker* w = (knapsack_choice_worker*) data;
+    knapsack_choice* g = w->g;
+    knapsack_context* c = w->c;
+
+    /* Contiguous capacities, whole rows of the picks */
+    int from = (int)((long)g->rows * w->rank / w->threads);
+    int to = (int)((long)g->rows * (w->rank + 1) / w->threads);
+
+    for(int s = 0; s < g->count; s++) {
+        float* previous = g->layers[s % 2];
+        float* next = g->layers[(s + 1) % 2];
+
+        for(int i = from; i < to; i++) {
+            float best = MINUS_INF;
+            int pick = 0;
+
+            /* Members are lighter first, stop at the first not fitting */
+            for(int k = g->starts[s]; k < g->starts[s + 1]; k++) {
+                int weight = g->weights[k];
+                if(weight > i) {
+                    break;
+                }
+                float before = previous[i - weight];
+                if(before == MINUS_INF) {
+                    continue;
+                }
+                float pay = before + c->items[g->members[k]]->value;
+                if(pay > best) {
+                    best = pay;
+                    pick = k - g->starts[s];
+                }
+            }
+            next[i] = best;
+            knapsack_decide(g->picks, i, s, pick);
+        }
+
+        /* Next group reads every capacity */
+        pthread_barrier_wait(&g->barrier);
+    }
+    return NULL;
+}
+
+/* Fill the rows group by group, in 'threads' threads */
+static bool knapsack_choice_solve(knapsack_context* c, knapsack_choice* g)
+{
+    int threads = (c->threads > 1) ? c->threads : 1;
+    if(threads > g->rows) {
+        threads = g->rows;
+    }
+    knapsack_choice_worker* workers = (knapsack_choice_worker*) malloc(
+                                threads * sizeof(knapsack_choice_worker));
+    GThread** handles = (GThread**) malloc(threads * sizeof(GThread*));
+    if((workers == NULL) || (handles == NULL)) {
+        free(workers);
+        free(handles);
+        return false;
+    }
+
+    pthread_barrier_init(&g->barrier, NULL, threads);
+    for(int t = 0; t < threads; t++) {
+        workers[t].g = g;
+        workers[t].c = c;
+        workers[t].rank = t;
+        workers[t].threads = threads;
+    }
+    for(int t = 1; t < threads; t++) {
+        handles[t] = g_thread_new("knapsack", knapsack_choice_work,
+                                  &workers[t]);
+    }
+    knapsack_choice_work(&workers[0]);
+    for(int t = 1; t < threads; t++) {
+        g_thread_join(handles[t]);
+    }
+    pthread_barrier_destroy(&g->barrier);
+
+    free(workers);
+    free(handles);
+    return true;
+}
+
+bool knapsack_groups(knapsack_context* c)
+{
+    /* Start counting time */
+    GTimer* timer = g_timer_new();
+
+    knapsack_choice g;
+    g.rows = c->capacity + 1;
+    g.layers[0] = NULL;
+    g.layers[1] = NULL;
+    g.picks = NULL;
+    bool success = knapsack_choice_filter(c, &g);
+
+    /* Bits for the position of the item picked in each group */
+    if(success) {
+        int* widths = (int*) malloc(g.count * sizeof(int));
+        success = (widths != NULL);
+        for(int s = 0; success && (s < g.count); s++) {
+            widths[s] = knapsack_decisions_width(
+                                    g.starts[s + 1] - g.starts[s] - 1);
+        }
+        if(success) {
+            g.picks = knapsack_decisions_new(g.rows, g.count, widths);
+        }
+        free(widths);
+        g.layers[0] = (float*) calloc(g.rows, sizeof(float));
+        g.layers[1] = (float*) malloc(g.rows * sizeof(float));
+        success = (g.picks != NULL) && (g.layers[0] != NULL) &&
+                  (g.layers[1] != NULL) && knapsack_choice_solve(c, &g);
+    }
+
+    /* Walk back the picks from the full capacity */
+    if(success) {
+        c->total_value = g.layers[g.count % 2][g.rows - 1];
+        success = (c->total_value != MINUS_INF);
+    }
+    if(success) {
+        for(int j = 0; j < c->num_items; j++) {
+            c->solution[j] = 0;
+        }
+        int i = g.rows - 1;
+        for(int s = g.count - 1; s > -1; s--) {
+            int k = g.starts[s] + knapsack_decision(g.picks, i, s);
+            c->solution[g.members[k]] = 1;
+            i -= g.weights[k];
+        }
+        c->memory_required += (2 * g.rows * sizeof(float)) +
+                              knapsack_decisions_sizeof(g.picks) +
+                              ((3 * c->num_items + 1) * sizeof(int));
+    }
+
+    free(g.members);
+    free(g.weights);
+    free(g.starts);
+    free(g.layers[0]);
+    free(g.layers[1]);
+    knapsack_decisions_free(g.picks);
+
+    /* Stop counting time */
+    g_timer_stop(timer);
+    c->execution_time = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+    return success;
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_KNAPSACK_GROUPS
+#define H_KNAPSACK_GROUPS
+
+#include "knapsack.h"
+
+/**
+ * Perform multiple-choice Knapsack algorithm: exactly one item of each group
+ * is put, as set in each item's 'group'.
+ *
+ * Weights are rounded up to whole units and amounts are ignored. Inside each
+ * group the items are sorted by weight and those not worth more than a
+ * lighter one are dropped, as they are never better. Groups are then added
+ * one at a time, keeping only the best value at every capacity for the
+ * groups so far in two rows of capacity + 1 values. The item picked at each
+ * capacity is recorded in as many bits as the group needs, see decisions.h,
+ * to walk back the solution. The capacities of each group are split between
+ * 'threads' threads.
+ *
+ * Only 'solution' and 'total_value' are filled, so the context can be created
+ * with knapsack_context_new_compact().
+ *
+ * @param knapsack_context, the knapsack's context data structure.
+ * @return TRUE if execution was successful or FALSE if an item has no group
+ *         or a negative weight, no choice of one item per group fits, or
+ *         memory ran out.
+ */
+bool knapsack_groups(knapsack_context* c);
+
+/**
+ * Tell if the items of a context are grouped, for the report.
+ */
+bool knapsack_is_grouped(knapsack_context* c);
+
+#endif
@@ -0,0 +1,428 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kernels.h"
+#include <stdint.h>
+
+/* Value of the previous column at row 'i', zero for the first item */
+static inline float knapsack_previous(knapsack_context* c, int i, int j)
+{
+    return (j > 0) ? c->table_values->data[i][j - 1] : 0.0;
+}
+
+/* Fill cell (i, j) of the tables trying every amount of the item */
+static inline void knapsack_cell(knapsack_context* c, int i, int j)
+{
+    /* Calculate Q and overflow */
+    item* it = c->items[j];
+    int q = fminf(it->amount, floorf((float)i / it->weight));
+    bool y_overflow = (j - 1) < 0;
+
+    /* Default and non putting the item */
+    int taken = 0;
+    float value = 0.0;
+    if(!y_overflow) {
+        value = c->table_values->data[i][j - 1];
+    }
+
+    /* Calculate if putting the item */
+    for(int times = 1; times < q + 1; times++) {
+        float pay = (float)times * it->value;
+        int prev_row = (int) floorf((float)i - (times * it->weight));
+        bool x_overflow = prev_row < 0;
+        if((!x_overflow) && (!y_overflow)) {
+            pay += c->table_values->data[prev_row][j - 1];
+        }
+        if(pay > value) {
+            value = pay;
+            taken = times;
+        }
+    }
+
+    c->table_values->data[i][j] = value;
+    knapsack_decide(c->table_items, i, j, taken);
+}
+
+/*
+ * Fill cell (i, j) of the tables for an item with more units than fit.
+ * Putting t items at row i is one more than putting t - 1 at row i - weight
+ * of this same column, already filled.
+ */
+static inline void knapsack_cell_unbounded(knapsack_context* c, int i, int j)
+{
+    item* it = c->items[j];
+    int weight = (int)it->weight;
+
+    int taken = 0;
+    float value = knapsack_previous(c, i, j);
+    if(i >= weight) {
+        float pay = it->value + c->table_values->data[i - weight][j];
+        if(pay > value) {
+            value = pay;
+            taken = knapsack_decision(c->table_items, i - weight, j) + 1;
+        }
+    }
+
+    c->table_values->data[i][j] = value;
+    knapsack_decide(c->table_items, i, j, taken);
+}
+
+knapsack_kind knapsack_kind_of(knapsack_context* c, item* it)
+{
+    if((it->weight < 1.0) || (it->weight != floorf(it->weight)) ||
+       (it->amount < 1.0)) {
+        return KNAPSACK_ANY;
+    }
+    float fit = floorf((float)c->capacity / it->weight);
+    if(fminf(it->amount, fit) <= KNAPSACK_SHIFTS_MAX) {
+        return KNAPSACK_SHIFTS;
+    }
+    if(it->amount >= fit) {
+        return KNAPSACK_UNBOUNDED;
+    }
+    return KNAPSACK_BOUNDED;
+}
+
+void knapsack_rows(knapsack_context* c, knapsack_kind* kinds,
+                   int first, int last, int from, int to)
+{
+    for(int i = from; i < to; i++) {
+        for(int j = first; j < last; j++) {
+            if(kinds[j] == KNAPSACK_UNBOUNDED) {
+                knapsack_cell_unbounded(c, i, j);
+            } else {
+                knapsack_cell(c, i, j);
+            }
+        }
+    }
+}
+
+SIMD_CLONES
+static void knapsack_shift_row(float pay, const float* restrict previous,
+                               float* restrict value, float* restrict taken,
+                               float times, int count)
+{
+    for(int k = 0; k < count; k++) {
+        float candidate = pay + previous[k];
+        bool better = candidate > value[k];
+        value[k] = better ? candidate : value[k];
+        taken[k] = better ? times : taken[k];
+    }
+}
+
+int knapsack_shifts_scratch(knapsack_context* c, int range)
+{
+    long previous = (long)(KNAPSACK_SHIFTS_MAX + 1) * range;
+    if(previous > c->table_values->rows) {
+        previous = c->table_values->rows;
+    }
+    return (2 * range) + (int)previous;
+}
+
+void knapsack_shifts(knapsack_context* c, int j, float* scratch,
+                     int from, int to)
+{
+    item* it = c->items[j];
+    int weight = (int)it->weight;
+    int range = to - from;
+    int amount = fminf(it->amount, floorf((float)(to - 1) / it->weight));
+    float* value = scratch;
+    float* taken = scratch + range;
+    float* previous = scratch + (2 * range);
+
+    /* Rows of the previous column read by each amount overlap if the weight
+     * is below the range, then they are gathered at once from the lowest */
+    bool overlap = weight < range;
+    int low = from - (amount * weight);
+    if(low < 0) {
+        low = 0;
+    }
+    if(overlap) {
+        for(int i = low; i < to; i++) {
+            previous[i - low] = knapsack_previous(c, i, j);
+        }
+    }
+
+    /* Same order and comparisons as trying every amount cell by cell */
+    int used = 0;
+    for(int times = 0; times <= amount; times++) {
+        int shift = times * weight;
+        int start = (from > shift) ? from : shift;
+        int count = to - start;
+
+        /* Rows [start - shift, to - shift) of the previous column */
+        const float* window = previous + (start - shift - low);
+        if(!overlap) {
+            for(int k = 0; k < count; k++) {
+                previous[used + k] = knapsack_previous(c, start - shift + k,
+                                                       j);
+            }
+            window = previous + used;
+            used += count;
+        }
+
+        if(times == 0) {
+            for(int k = 0; k < range; k++) {
+                value[k] = window[k];
+                taken[k] = 0.0;
+            }
+            continue;
+        }
+        knapsack_shift_row((float)times * it->value, window,
+                           value + (start - from), taken + (start - from),
+                           (float)times, count);
+    }
+
+    /* Scatter back to the tables */
+    for(int i = from; i < to; i++) {
+        c->table_values->data[i][j] = value[i - from];
+        knapsack_decide(c->table_items, i, j, (int)taken[i - from]);
+    }
+}
+
+/*
+ * Rows with the same residue modulo the weight are one item apart, so for the
+ * m-th of them the best is the maximum of previous(k) - k x value over the
+ * last 'amount' positions k, plus m x value. That sliding maximum is kept in a
+ * monotone deque, making the column O(capacity) whatever the amount.
+ */
+static void knapsack_residue_deque(knapsack_context* c, int j, int* deque,
+                                   int r)
+{
+    item* it = c->items[j];
+    int weight = (int)it->weight;
+    int rows = c->table_values->rows;
+
+    int head = 0;
+    int tail = 0;
+
+    for(int m = 0; r + (m * weight) < rows; m++) {
+        int i = r + (m * weight);
+
+        /* Push position m, on ties keep the one putting less items */
+        float key = knapsack_previous(c, i, j) - (float)m * it->value;
+        while(tail > head) {
+            int k = deque[tail - 1];
+            float back = knapsack_previous(c, r + (k * weight), j) -
+                         (float)k * it->value;
+            if(back > key) {
+                break;
+            }
+            tail--;
+        }
+        deque[tail++] = m;
+
+        /* Drop positions needing more items than available */
+        int q = fminf(it->amount, (float)m);
+        while(deque[head] < m - q) {
+            head++;
+        }
+
+        int taken = m - deque[head];
+        float value = knapsack_previous(c, i, j);
+        if(taken > 0) {
+            value = (float)taken * it->value +
+                    knapsack_previous(c, i - (taken * weight), j);
+        }
+
+        c->table_values->data[i][j] = value;
+        knapsack_decide(c->table_items, i, j, taken);
+    }
+}
+
+int knapsack_residues_deque(knapsack_context* c, int weight)
+{
+    return (c->table_values->rows + weight - 1) / weight;
+}
+
+void knapsack_residues(knapsack_context* c, int j, int* deque,
+                       int from, int to)
+{
+    int weight = (int)c->items[j]->weight;
+    bool unbounded = knapsack_kind_of(c, c->items[j]) == KNAPSACK_UNBOUNDED;
+
+    for(int r = from; r < to; r++) {
+        if(!unbounded) {
+            knapsack_residue_deque(c, j, deque, r);
+            continue;
+        }
+        for(int i = r; i < c->table_values->rows; i += weight) {
+            knapsack_cell_unbounded(c, i, j);
+        }
+    }
+}
+
+bool knapsack_column(knapsack_context* c, int j)
+{
+    int rows = c->table_values->rows;
+    knapsack_kind kind = knapsack_kind_of(c, c->items[j]);
+
+    if(kind == KNAPSACK_SHIFTS) {
+        float* scratch = (float*) malloc(knapsack_shifts_scratch(c, rows) *
+                                         sizeof(float));
+        if(scratch == NULL) {
+            return false;
+        }
+        knapsack_shifts(c, j, scratch, 0, rows);
+        free(scratch);
+    } else if(kind == KNAPSACK_BOUNDED) {
+        int weight = (int)c->items[j]->weight;
+        int* deque = (int*) malloc(knapsack_residues_deque(c, weight) *
+                                   sizeof(int));
+        if(deque == NULL) {
+            return false;
+        }
+        knapsack_residues(c, j, deque, 0, (weight < rows) ? weight : rows);
+        free(deque);
+    } else {
+        for(int i = 0; i < rows; i++) {
+            if(kind == KNAPSACK_UNBOUNDED) {
+                knapsack_cell_unbounded(c, i, j);
+            } else {
+                knapsack_cell(c, i, j);
+            }
+        }
+    }
+    return true;
+}
+
+int knapsack_width(knapsack_context* c, item* it)
+{
+    float units = it->amount;
+    if(it->weight > 0.0) {
+        units = fminf(units, floorf((float)c->capacity / it->weight));
+    }
+    return knapsack_decisions_width(units);
+}
+
+/* Bytes of the tables, with room for every item slot */
+static unsigned int knapsack_tables_sizeof(knapsack_context* c)
+{
+    return (c->table_values->rows * sizeof(float*)) +
+           (c->table_values->rows * c->items_size * sizeof(float)) +
+           knapsack_decisions_sizeof(c->table_items);
+}
+
+void knapsack_tables_free(knapsack_context* c)
+{
+    if(c->table_values != NULL) {
+        c->memory_required -= knapsack_tables_sizeof(c);
+    }
+    matrix_free(c->table_values);
+    knapsack_decisions_free(c->table_items);
+    c->table_values = NULL;
+    c->table_items = NULL;
+}
+
+bool knapsack_layout(knapsack_context* c)
+{
+    /* Values with a column per item slot, for knapsack_append() */
+    int rows = c->capacity + 1;
+    matrix* values = matrix_new(rows, c->items_size, 0.0);
+    int* widths = (int*) malloc(c->num_items * sizeof(int));
+    if((values == NULL) || (widths == NULL)) {
+        matrix_free(values);
+        free(widths);
+        return false;
+    }
+    for(int j = 0; j < c->num_items; j++) {
+        widths[j] = knapsack_width(c, c->items[j]);
+    }
+    knapsack_decisions* d = knapsack_decisions_new(rows, c->num_items,
+                                                   widths);
+    free(widths);
+    if(d == NULL) {
+        matrix_free(values);
+        return false;
+    }
+    values->columns = c->num_items;
+
+    knapsack_tables_free(c);
+    c->table_values = values;
+    c->table_items = d;
+    c->memory_required += knapsack_tables_sizeof(c);
+    return true;
+}
+
+bool knapsack_is_subset_sum(knapsack_context* c)
+{
+    for(int j = 0; j < c->num_items; j++) {
+        item* it = c->items[j];
+        if((knapsack_kind_of(c, it) == KNAPSACK_ANY) ||
+           (it->amount != 1.0) || (it->value != it->weight)) {
+            return false;
+        }
+    }
+    return c->num_items > 0;
+}
+
+bool knapsack_subset_sum(knapsack_context* c)
+{
+    int rows = c->table_values->rows;
+    int words = (rows + 63) / 64;
+    uint64_t* reach = (uint64_t*) calloc((size_t)words * c->num_items,
+                                         sizeof(uint64_t));
+    int* best = (int*) calloc(c->num_items, sizeof(int));
+    if((reach == NULL) || (best == NULL)) {
+        free(reach);
+        free(best);
+        return false;
+    }
+
+    for(int j = 0; j < c->num_items; j++) {
+        uint64_t* now = reach + ((size_t)j * words);
+        if(j == 0) {
+            now[0] = 1;
+        } else {
+            memcpy(now, now - words, words * sizeof(uint64_t));
+        }
+
+        /* Shift in place from the top so lower words are still unchanged */
+        int weight = (int)c->items[j]->weight;
+        int skip = weight / 64;
+        int bits = weight % 64;
+        for(int w = words - 1; w >= skip; w--) {
+            uint64_t shifted = now[w - skip] << bits;
+            if((bits > 0) && (w - skip > 0)) {
+                shifted |= now[w - skip - 1] >> (64 - bits);
+            }
+            now[w] |= shifted;
+        }
+    }
+
+    /* Row by row, following the tables layout */
+    for(int i = 0; i < rows; i++) {
+        int word = i / 64;
+        uint64_t mask = (uint64_t)1 << (i % 64);
+        float* values = c->table_values->data[i];
+        int previous = 0;
+
+        for(int j = 0; j < c->num_items; j++) {
+            if(reach[((size_t)j * words) + word] & mask) {
+                best[j] = i;
+            }
+            values[j] = (float)best[j];
+            knapsack_decide(c->table_items, i, j, best[j] > previous);
+            previous = best[j];
+        }
+    }
+
+    free(reach);
+    free(best);
+    return true;
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_KNAPSACK_KERNELS
+#define H_KNAPSACK_KERNELS
+
+#include "knapsack.h"
+
+/* Most units of an item filled as shifted copies of the previous column */
+#define KNAPSACK_SHIFTS_MAX 8
+
+/* Rows filled at once, so gathered columns are still in cache for the next */
+#define KNAPSACK_BLOCK 1024
+
+/**
+ * Kernel used to fill each column of the tables.
+ */
+typedef enum {
+    KNAPSACK_ANY,       /* Trying every amount */
+    KNAPSACK_SHIFTS,    /* Integral weight, few units fit */
+    KNAPSACK_BOUNDED,   /* Integral weight, sliding window of amounts */
+    KNAPSACK_UNBOUNDED  /* Integral weight, more units than fit */
+} knapsack_kind;
+knapsack_kind knapsack_kind_of(knapsack_context* c, item* it);
+
+/**
+ * Bits the amounts of an item take in 'table_items', enough for the most
+ * units the kernels can put, with the same rounding.
+ */
+int knapsack_width(knapsack_context* c, item* it);
+
+/**
+ * Allocate the tables for the current items and capacity, all zero,
+ * replacing the previous ones. 'table_items' is laid out with the width of
+ * each item. Kernels need it before filling any column.
+ *
+ * @return FALSE if memory ran out, in which case the context is unchanged.
+ */
+bool knapsack_layout(knapsack_context* c);
+
+/**
+ * Release the tables of a context, if any, leaving them NULL.
+ */
+void knapsack_tables_free(knapsack_context* c);
+
+/**
+ * Fill rows [from, to) of columns [first, last) of the tables, row by row as
+ * they are stored. Columns must be of kind KNAPSACK_ANY or
+ * KNAPSACK_UNBOUNDED, and for the later the rows above 'from' must be
+ * filled.
+ */
+void knapsack_rows(knapsack_context* c, knapsack_kind* kinds,
+                   int first, int last, int from, int to);
+
+/**
+ * Fill rows [from, to) of column 'j', of kind KNAPSACK_SHIFTS. The rows of
+ * the previous column each amount reads are gathered in a contiguous array
+ * and each amount of the item is a vectorized max and blend of them, with
+ * runtime dispatch between instruction sets. Same values as trying every
+ * amount.
+ *
+ * @param scratch, room for knapsack_shifts_scratch(c, to - from) floats.
+ */
+void knapsack_shifts(knapsack_context* c, int j, float* scratch,
+                     int from, int to);
+
+/**
+ * Floats of scratch knapsack_shifts() needs for a range of rows: the range's
+ * values and amounts, and the previous column rows read by up to
+ * KNAPSACK_SHIFTS_MAX amounts, never more than the table has.
+ */
+int knapsack_shifts_scratch(knapsack_context* c, int range);
+
+/**
+ * Fill the rows of column 'j' whose residue modulo the item's integral
+ * weight is in [from, to). Residues are independent of each other.
+ *
+ * @param deque, room for knapsack_residues_deque() positions.
+ */
+void knapsack_residues(knapsack_context* c, int j, int* deque,
+                       int from, int to);
+
+/**
+ * Positions the deque of knapsack_residues() needs for an item's integral
+ * weight, the rows of one residue.
+ */
+int knapsack_residues_deque(knapsack_context* c, int weight);
+
+/**
+ * Fill the whole column 'j' with the kernel of its kind, given the previous
+ * one is filled.
+ *
+ * @return FALSE if the kernel's scratch space couldn't be allocated.
+ */
+bool knapsack_column(knapsack_context* c, int j);
+
+/**
+ * Tell if every item is a single unit worth its integral weight.
+ */
+bool knapsack_is_subset_sum(knapsack_context* c);
+
+/**
+ * Fill the tables of a subset sum instance. The sums reachable with the
+ * first j items are kept in a bitset per item, adding an item is or-ing the
+ * previous bitset with itself shifted by the weight, 64 sums at a time. The
+ * value at row i is the largest reachable sum not above i, and the item was
+ * put if that improved on the previous item.
+ *
+ * @return FALSE if the bitsets couldn't be allocated.
+ */
+bool knapsack_subset_sum(knapsack_context* c);
+
+#endif
@@ -17,6 +17,8 @@
  */
 
 #include "knapsack.h"
+#include "kernels.h"
+#include <limits.h>
 
 void item_new(item* it, char* name, float value, float weight, float amount)
 {
@@ -24,9 +26,24 @@ void item_new(item* it, char* name, float value, float weight, float amount)
     it->value = value;
     it->weight = weight;
     it->amount = amount;
+    it->sizes[0] = weight;
+    for(int d = 1; d < KNAPSACK_DIMENSIONS; d++) {
+        it->sizes[d] = 0.0;
+    }
+    it->group = -1;
 }
 
-knapsack_context* knapsack_context_new(int capacity, int num_items)
+void item_new_sizes(item* it, char* name, float value, int dimensions,
+                    float* sizes, float amount)
+{
+    item_new(it, name, value, sizes[0], amount);
+    for(int d = 1; d < dimensions; d++) {
+        it->sizes[d] = sizes[d];
+    }
+}
+
+static knapsack_context* knapsack_context_alloc(int capacity, int num_items,
+                                                bool tables)
 {
     /* Check input is correct */
     if((capacity < 1) || (num_items < 1)) {
@@ -39,15 +56,14 @@ knapsack_context* knapsack_context_new(int capacity, int num_items)
         return NULL;
     }
 
-    /* Try to allocate matrices */
-    c->table_values = matrix_new(capacity + 1, num_items, 0.0);
-    if(c->table_values == NULL) {
-        free(c);
-        return NULL;
-    }
-    c->table_items = matrix_new(capacity + 1, num_items, 0.0);
-    if(c->table_items == NULL) {
-        matrix_free(c->table_values);
+    /* Tables are allocated when solving, see knapsack() */
+    c->table_values = NULL;
+    c->table_items = NULL;
+    c->tables = tables;
+
+    /* Try to allocate solution */
+    c->solution = (int*) calloc(num_items, sizeof(int));
+    if(c->solution == NULL) {
         free(c);
         return NULL;
     }
@@ -55,8 +71,7 @@ knapsack_context* knapsack_context_new(int capacity, int num_items)
     /* Try to allocate items array */
     c->items = (item**) malloc(num_items * sizeof(item*));
     if(c->items == NULL) {
-        matrix_free(c->table_values);
-        matrix_free(c->table_items);
+        free(c->solution);
         free(c);
         return NULL;
     }
@@ -75,8 +90,7 @@ knapsack_context* knapsack_context_new(int capacity, int num_items)
 
             /* Free the items array */
             free(c->items);
-            matrix_free(c->table_values);
-            matrix_free(c->table_items);
+            free(c->solution);
             free(c);
             return NULL;
         }
@@ -84,82 +98,460 @@ knapsack_context* knapsack_context_new(int capacity, int num_items)
 
     /* Initialize the items array */
     for(int i = 0; i < num_items; i++) {
-        c->items[i]->name = "";
-        c->items[i]->value = 0.0;
-        c->items[i]->weight = 0.0;
-        c->items[i]->amount = 0.0;
+        item_new(c->items[i], "", 0.0, 0.0, 0.0);
     }
 
     c->num_items = num_items;
+    c->items_size = num_items;
     c->capacity = capacity;
+    c->dimensions = 1;
+    c->capacities[0] = capacity;
+    for(int d = 1; d < KNAPSACK_DIMENSIONS; d++) {
+        c->capacities[d] = 0;
+    }
     c->unit = "";
+    c->threads = 1;
+    c->scale = 1;
+    c->divisor = 0;
+    c->total_value = 0.0;
 
     c->status = -1;
     c->execution_time = 0.0;
-    c->memory_required = (matrix_sizeof(c->table_values) * 2) +
-                         (num_items * sizeof(item)) +
+    c->memory_required = (num_items * sizeof(item)) +
                          (num_items * sizeof(item*)) +
+                         (num_items * sizeof(int)) +
                          sizeof(knapsack_context);
     c->report_buffer = tmpfile();
 
     return c;
 }
 
+knapsack_context* knapsack_context_new(int capacity, int num_items)
+{
+    return knapsack_context_alloc(capacity, num_items, true);
+}
+
+knapsack_context* knapsack_context_new_compact(int capacity, int num_items)
+{
+    return knapsack_context_alloc(capacity, num_items, false);
+}
+
 void knapsack_context_free(knapsack_context* c)
 {
-    matrix_free(c->table_values);
-    matrix_free(c->table_items);
+    knapsack_tables_free(c);
     for(int i = 0; i < c->num_items; i++) {
         free(c->items[i]);
     }
     free(c->items);
+    free(c->solution);
     fclose(c->report_buffer);
     free(c);
     return;
 }
 
-bool knapsack(knapsack_context *c)
+/* Weight in fixed point units, FALSE if it isn't a whole number of them */
+static bool knapsack_fixed(knapsack_context* c, float weight, long* units)
 {
-    /* Start counting time */
-    GTimer* timer = g_timer_new();
+    double scaled = (double)weight * c->scale;
+    double whole = rint(scaled);
+    if((c->scale < 1) || (scaled < 0.0) || (scaled > INT_MAX) ||
+       (fabs(scaled - whole) > scaled * FLT_EPSILON)) {
+        return false;
+    }
+    *units = (long)whole;
+    return true;
+}
 
-    for(int i = 0; i < c->table_values->rows; i++) {
-        for(int j = 0; j < c->table_values->columns; j++) {
+/* Greatest common divisor of the fixed point weights, 0 if there are not */
+static int knapsack_divisor(knapsack_context* c)
+{
+    long divisor = 0;
+    for(int j = 0; j < c->num_items; j++) {
+        long units;
+        if(!knapsack_fixed(c, c->items[j]->weight, &units)) {
+            return 0;
+        }
+        while(units != 0) {
+            long rest = divisor % units;
+            divisor = units;
+            units = rest;
+        }
+    }
+    return (divisor == 0) ? c->scale : (int)divisor;
+}
 
-            /* Calculate Q and overflow */
-            item* it = c->items[j];
-            int q = fminf(it->amount, floorf((float)i / it->weight));
-            bool y_overflow = (j - 1) < 0;
+/**
+ * The items and capacity as the kernels see them while filling the tables:
+ * with fixed point rows, copies of the items weighting their rows.
+ */
+typedef struct {
+    item** items;
+    int capacity;
+    void* reduced;
+} knapsack_view;
 
-            /* Default and non putting the item */
-            int taken = 0;
-            float value = 0.0;
-            if(!y_overflow) {
-                value = c->table_values->data[i][j - 1];
-            }
+static bool knapsack_enter(knapsack_context* c, knapsack_view* view)
+{
+    view->items = c->items;
+    view->capacity = c->capacity;
+    view->reduced = NULL;
+    if(c->divisor == 0) {
+        return true;
+    }
 
-            /* Calculate if putting the item */
-            for(int times = 1; times < q + 1; times++) {
-                float pay = (float)times * it->value;
-                int prev_row = (int) floorf((float)i - (times * it->weight));
-                bool x_overflow = prev_row < 0;
-                if((!x_overflow) && (!y_overflow)) {
-                    pay += c->table_values->data[prev_row][j - 1];
-                }
-                if(pay > value) {
-                    value = pay;
-                    taken = times;
-                }
+    /* Pointers to the copies first, then the copies */
+    view->reduced = malloc(c->num_items * (sizeof(item*) + sizeof(item)));
+    if(view->reduced == NULL) {
+        return false;
+    }
+    item** pointers = (item**) view->reduced;
+    item* copies = (item*) (pointers + c->num_items);
+    for(int j = 0; j < c->num_items; j++) {
+        long units = 0;
+        knapsack_fixed(c, c->items[j]->weight, &units);
+        copies[j] = *c->items[j];
+        copies[j].weight = (float)(units / c->divisor);
+        copies[j].sizes[0] = copies[j].weight;
+        pointers[j] = &copies[j];
+    }
+    c->items = pointers;
+    c->capacity = knapsack_row(c, c->capacity);
+    return true;
+}
+
+static void knapsack_leave(knapsack_context* c, knapsack_view* view)
+{
+    c->items = view->items;
+    c->capacity = view->capacity;
+    free(view->reduced);
+}
+
+/* Fill columns [first, last), none of them bounded, a block of rows at once */
+static void knapsack_blocks(knapsack_context* c, knapsack_kind* kinds,
+                            float* scratch, int first, int last)
+{
+    int rows = c->table_values->rows;
+    for(int from = 0; from < rows; from += KNAPSACK_BLOCK) {
+        int to = (from + KNAPSACK_BLOCK < rows) ? from + KNAPSACK_BLOCK : rows;
+
+        /* Shifted columns one by one, runs of the others row by row */
+        int j = first;
+        while(j < last) {
+            if(kinds[j] == KNAPSACK_SHIFTS) {
+                knapsack_shifts(c, j, scratch, from, to);
+                j++;
+                continue;
+            }
+            int end = j;
+            while((end < last) && (kinds[end] != KNAPSACK_SHIFTS)) {
+                end++;
             }
+            knapsack_rows(c, kinds, j, end, from, to);
+            j = end;
+        }
+    }
+}
 
-            c->table_values->data[i][j] = value;
-            c->table_items->data[i][j] = (float)taken;
+/* Fill the tables in the calling thread */
+static bool knapsack_serial(knapsack_context* c)
+{
+    /* Kernel per item and scratch space for the column kernels */
+    int rows = c->table_values->rows;
+    int columns = c->table_values->columns;
+    knapsack_kind* kinds = (knapsack_kind*) malloc(
+                                        columns * sizeof(knapsack_kind));
+    int block = (rows < KNAPSACK_BLOCK) ? rows : KNAPSACK_BLOCK;
+    int* deque = (int*) malloc(rows * sizeof(int));
+    float* scratch = (float*) malloc(knapsack_shifts_scratch(c, block) *
+                                     sizeof(float));
+    if((kinds == NULL) || (deque == NULL) || (scratch == NULL)) {
+        free(kinds);
+        free(deque);
+        free(scratch);
+        return false;
+    }
+    for(int j = 0; j < columns; j++) {
+        kinds[j] = knapsack_kind_of(c, c->items[j]);
+    }
+
+    /* Bounded columns need every row at once, the others go in blocks */
+    int j = 0;
+    while(j < columns) {
+        if(kinds[j] == KNAPSACK_BOUNDED) {
+            int weight = (int)c->items[j]->weight;
+            knapsack_residues(c, j, deque, 0,
+                              (weight < rows) ? weight : rows);
+            j++;
+            continue;
+        }
+        int last = j;
+        while((last < columns) && (kinds[last] != KNAPSACK_BOUNDED)) {
+            last++;
         }
+        knapsack_blocks(c, kinds, scratch, j, last);
+        j = last;
     }
 
+    free(kinds);
+    free(deque);
+    free(scratch);
+    return true;
+}
+
+bool knapsack_set_dimensions(knapsack_context* c, int dimensions,
+                             int* capacities)
+{
+    if((dimensions < 1) || (dimensions > KNAPSACK_DIMENSIONS) ||
+       (capacities[0] != c->capacity)) {
+        return false;
+    }
+    for(int d = 0; d < dimensions; d++) {
+        if(capacities[d] < 0) {
+            return false;
+        }
+    }
+
+    c->dimensions = dimensions;
+    for(int d = 0; d < KNAPSACK_DIMENSIONS; d++) {
+        c->capacities[d] = (d < dimensions) ? capacities[d] : 0;
+    }
+    return true;
+}
+
+bool knapsack(knapsack_context *c)
+{
+    /* Rows of the tables, fewer if the weights have a common divisor */
+    int divisor = knapsack_divisor(c);
+    double rows = c->capacity + 1.0;
+    if(divisor != 0) {
+        rows = floor((double)c->capacity * c->scale / divisor) + 1.0;
+    }
+
+    /* Tables too large, search instead */
+    if(!c->tables ||
+       (2.0 * rows * c->num_items * sizeof(float) > KNAPSACK_TABLES_BUDGET)) {
+        knapsack_tables_free(c);
+        return knapsack_branch(c);
+    }
+
+    /* Start counting time */
+    GTimer* timer = g_timer_new();
+
+    /* Fill the tables in rows as the kernels see them */
+    knapsack_view view;
+    c->divisor = divisor;
+    bool success = knapsack_enter(c, &view);
+    if(success) {
+
+        /* Subset sums fit in machine words */
+        if(!knapsack_layout(c)) {
+            success = false;
+        } else if(knapsack_is_subset_sum(c)) {
+            success = knapsack_subset_sum(c);
+        } else if(c->threads > 1) {
+            success = knapsack_threads(c, c->threads);
+        } else {
+            success = knapsack_serial(c);
+        }
+        knapsack_leave(c, &view);
+    }
+    if(!success) {
+        knapsack_tables_free(c);
+        g_timer_destroy(timer);
+        return false;
+    }
+    knapsack_backtrack(c);
+
     /* Stop counting time */
     g_timer_stop(timer);
     c->execution_time = g_timer_elapsed(timer, NULL);
     g_timer_destroy(timer);
     return true;
 }
+
+int knapsack_row(knapsack_context* c, int capacity)
+{
+    if(c->divisor == 0) {
+        return capacity;
+    }
+    return (int)(((long long)capacity * c->scale) / c->divisor);
+}
+
+/* Rows taken by some units of an item */
+static int knapsack_rows_of(knapsack_context* c, item* it, int units)
+{
+    long weight = 0;
+    if(c->divisor == 0) {
+        return (int)ceilf((float)units * it->weight);
+    }
+    knapsack_fixed(c, it->weight, &weight);
+    return units * (int)(weight / c->divisor);
+}
+
+void knapsack_backtrack(knapsack_context* c)
+{
+    knapsack_query(c, c->capacity, &c->total_value, c->solution);
+}
+
+bool knapsack_query(knapsack_context* c, int capacity, float* value,
+                    int* solution)
+{
+    knapsack_decisions* ti = c->table_items;
+    if((ti == NULL) || (capacity < 0) || (capacity > c->capacity)) {
+        return false;
+    }
+
+    int row = knapsack_row(c, capacity);
+    *value = c->table_values->data[row][ti->columns - 1];
+    if(solution == NULL) {
+        return true;
+    }
+
+    for(int at_item = ti->columns - 1; at_item > -1; at_item--) {
+        int put_items = knapsack_decision(ti, row, at_item);
+        solution[at_item] = put_items;
+        row -= knapsack_rows_of(c, c->items[at_item], put_items);
+    }
+    return true;
+}
+
+bool knapsack_query_batch(knapsack_context* c, int count, int* capacities,
+                          float* values)
+{
+    for(int q = 0; q < count; q++) {
+        if(!knapsack_query(c, capacities[q], &values[q], NULL)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Grow every row of a table to 'size' columns, keeping its contents */
+static bool knapsack_table_grow(matrix* m, int size)
+{
+    for(int i = 0; i < m->rows; i++) {
+        float* row = (float*) realloc(m->data[i], size * sizeof(float));
+        if(row == NULL) {
+            return false;
+        }
+        m->data[i] = row;
+    }
+    return true;
+}
+
+/* Double the slots for items and table columns */
+static bool knapsack_grow(knapsack_context* c)
+{
+    int size = c->items_size * 2;
+
+    item** items = (item**) realloc(c->items, size * sizeof(item*));
+    if(items == NULL) {
+        return false;
+    }
+    c->items = items;
+
+    int* solution = (int*) realloc(c->solution, size * sizeof(int));
+    if(solution == NULL) {
+        return false;
+    }
+    c->solution = solution;
+
+    /* Rows already grown are just larger if another one fails */
+    if(c->table_values != NULL) {
+        if(!knapsack_table_grow(c->table_values, size)) {
+            return false;
+        }
+        c->memory_required += c->table_values->rows *
+                              (size - c->items_size) * sizeof(float);
+    }
+    c->memory_required += (size - c->items_size) *
+                          (sizeof(item*) + sizeof(int));
+    c->items_size = size;
+    return true;
+}
+
+/* Take back the last item appended, without touching the tables */
+static void knapsack_unappend(knapsack_context* c)
+{
+    c->num_items--;
+    c->memory_required -= sizeof(item);
+    free(c->items[c->num_items]);
+}
+
+bool knapsack_append(knapsack_context* c, char* name, float value,
+                     float weight, float amount)
+{
+    if((c->num_items == c->items_size) && !knapsack_grow(c)) {
+        return false;
+    }
+    item* it = (item*) malloc(sizeof(item));
+    if(it == NULL) {
+        return false;
+    }
+    item_new(it, name, value, weight, amount);
+
+    int j = c->num_items;
+    c->items[j] = it;
+    c->solution[j] = 0;
+    c->num_items++;
+    c->memory_required += sizeof(item);
+    if(c->table_values == NULL) {
+        return true;
+    }
+
+    /* Weights off the fixed point rows need other tables */
+    long units = 0;
+    if((c->divisor != 0) &&
+       (!knapsack_fixed(c, weight, &units) || (units % c->divisor != 0))) {
+        if(knapsack(c)) {
+            return true;
+        }
+        knapsack_unappend(c);
+        return false;
+    }
+
+    /* New column from the last one, amounts in as many bits as it needs */
+    knapsack_view view;
+    bool decided = knapsack_enter(c, &view);
+    bool filled = false;
+    if(decided) {
+        unsigned int before = knapsack_decisions_sizeof(c->table_items);
+        decided = knapsack_decisions_append(c->table_items,
+                                            knapsack_width(c, c->items[j]));
+        c->memory_required += knapsack_decisions_sizeof(c->table_items) -
+                              before;
+        if(decided) {
+            c->table_values->columns++;
+            filled = knapsack_column(c, j);
+        }
+        knapsack_leave(c, &view);
+    }
+    if(!filled) {
+        if(decided) {
+            c->table_values->columns--;
+            c->table_items->columns--;
+        }
+        knapsack_unappend(c);
+        return false;
+    }
+    knapsack_backtrack(c);
+    return true;
+}
+
+bool knapsack_remove(knapsack_context* c)
+{
+    if(c->num_items < 2) {
+        return false;
+    }
+    c->num_items--;
+    free(c->items[c->num_items]);
+    c->memory_required -= sizeof(item);
+    if(c->table_values != NULL) {
+        c->table_values->columns--;
+        if(c->table_items != NULL) {
+            c->table_items->columns--;
+        }
+        knapsack_backtrack(c);
+    }
+    return true;
+}
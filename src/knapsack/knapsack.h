@@ -21,6 +21,13 @@
 
 #include "utils.h"
 #include "matrix.h"
+#include "decisions.h"
+
+/* Most constraints an item can be measured in, see multi.h */
+#define KNAPSACK_DIMENSIONS 4
+
+/* Most bytes for the tables, beyond it knapsack() uses branch.h */
+#define KNAPSACK_TABLES_BUDGET (1 << 30)
 
 /**
  * Item definition struct.
@@ -30,9 +37,25 @@ typedef struct {
     float value;
     float weight;
     float amount;
+
+    /* Size on each constraint (volume, ...), the first one is the weight */
+    float sizes[KNAPSACK_DIMENSIONS];
+
+    /* Group to pick exactly one item of, see groups.h, -1 if none */
+    int group;
 } item;
 void item_new(item* it, char* name, float value, float weight, float amount);
 
+/**
+ * Create an item measured in several constraints.
+ *
+ * @param dimensions, the number of constraints, up to KNAPSACK_DIMENSIONS.
+ * @param sizes, the item's size on each constraint, the weight first.
+ * @return nothing, sizes beyond 'dimensions' are zero.
+ */
+void item_new_sizes(item* it, char* name, float value, int dimensions,
+                    float* sizes, float amount);
+
 /**
  * Knapsack algorithm context data structure.
  */
@@ -44,9 +67,9 @@ typedef struct {
     unsigned int memory_required;
     FILE* report_buffer;
 
-    /* Tables */
+    /* Tables, the amounts are laid out for the items when solving */
     matrix* table_values;
-    matrix* table_items;
+    knapsack_decisions* table_items;
 
     /* Algorithm */
     int num_items;
@@ -54,20 +77,149 @@ typedef struct {
     int capacity;
     char* unit;
 
+    /* Constraints, the first capacity is 'capacity', see multi.h */
+    int dimensions;
+    int capacities[KNAPSACK_DIMENSIONS];
+
+    /* Slots allocated for items and table columns, see knapsack_append() */
+    int items_size;
+
+    /* Worker threads, see threads.h */
+    int threads;
+
+    /* Fixed point units per weight unit, 1 by default. When every weight is
+     * a multiple of 1 / scale the tables are filled in fixed point, one row
+     * per 'divisor' units, the greatest common divisor of the weights */
+    int scale;
+    int divisor;    /* 0 if the rows are whole capacity units instead */
+
+    /* If knapsack() fills tables, see knapsack_context_new_compact() */
+    bool tables;
+
+    /* Solution */
+    float total_value;
+    int* solution;
+
 } knapsack_context;
 
+/**
+ * Create a knapsack context. The tables are allocated by knapsack(), once the
+ * weights are known, see knapsack_row().
+ */
 knapsack_context* knapsack_context_new(int capacity, int num_items);
 void knapsack_context_free(knapsack_context* c);
 
+/**
+ * Create a knapsack context without tables, for engines that only need the
+ * items and fill the solution directly. 'table_values' and 'table_items' stay
+ * NULL and knapsack() uses knapsack_branch().
+ */
+knapsack_context* knapsack_context_new_compact(int capacity, int num_items);
+
+/**
+ * Constrain the knapsack in several dimensions, for knapsack_multi().
+ *
+ * @param dimensions, the number of constraints, up to KNAPSACK_DIMENSIONS.
+ * @param capacities, the capacity on each constraint, the first one must be
+ *        the context's capacity.
+ * @return FALSE if the dimensions or capacities are out of range.
+ */
+bool knapsack_set_dimensions(knapsack_context* c, int dimensions,
+                             int* capacities);
+
 /**
  * Perform Knapsack algorithm with given context.
  *
+ * If 'threads' is greater than one the rows of each item are split between
+ * that many threads, with the same results. The amounts in 'table_items' are
+ * packed in the bits each item needs, see decisions.h.
+ *
+ * If every weight is a multiple of 1 / 'scale' they are taken in fixed point,
+ * exactly, and divided by their greatest common divisor before allocating the
+ * tables, so weights 250, 500 and 750 need 250 times less rows. Otherwise
+ * there is a row per capacity unit and fractional weights are rounded up when
+ * combined. When the tables would take more than KNAPSACK_TABLES_BUDGET bytes,
+ * or the context is compact, knapsack_branch() searches the solution instead.
+ *
  * @param knapsack_context, the knapsack's context data structure.
  * @return TRUE if execution was successful or FALSE if and error ocurred. Check
  *         'status' flag in context to know what went wrong.
  */
 bool knapsack(knapsack_context* c);
 
+/**
+ * Row of the tables holding a capacity, between 0 and the context's.
+ */
+int knapsack_row(knapsack_context* c, int capacity);
+
+/**
+ * Fill 'solution' and 'total_value' walking back the tables from the last
+ * item at full capacity.
+ *
+ * @param knapsack_context, the knapsack's context after filling the tables.
+ * @return nothing
+ */
+void knapsack_backtrack(knapsack_context* c);
+
+/**
+ * Answer the optimum for another capacity from the tables of a solved
+ * context. The last column of 'table_values' already holds the optimum for
+ * every capacity up to the solved one, and walking back 'table_items' from
+ * that row gives the amount put of each item, so nothing is recomputed.
+ *
+ * @param knapsack_context, the knapsack's context after knapsack().
+ * @param capacity, between 0 and the context's capacity.
+ * @param value, where to store the optimal value.
+ * @param solution, where to store the amount put of each item, 'num_items'
+ *        long, or NULL if only the value is needed.
+ * @return FALSE if the capacity is out of range or the context has no
+ *         tables.
+ */
+bool knapsack_query(knapsack_context* c, int capacity, float* value,
+                    int* solution);
+
+/**
+ * Answer the optimal value of a batch of capacities, one table lookup each.
+ *
+ * @param count, the number of capacities.
+ * @param capacities, the capacities asked, each as in knapsack_query().
+ * @param values, where to store each optimal value, 'count' long.
+ * @return FALSE if any capacity is out of range or the context has no
+ *         tables.
+ */
+bool knapsack_query_batch(knapsack_context* c, int count, int* capacities,
+                          float* values);
+
+/**
+ * Append an item to a context, solved or not. Slots for items and table
+ * columns are grown geometrically, so appending is amortized O(capacity):
+ * the new column is computed from the last one and the solution is walked
+ * back again. Contexts without tables only get the item, and an item whose
+ * weight breaks the fixed point rows of the tables solves them again.
+ *
+ * @param knapsack_context, the knapsack's context data structure.
+ * @return TRUE if the item was appended or FALSE if memory ran out, in which
+ *         case the context is unchanged.
+ */
+bool knapsack_append(knapsack_context* c, char* name, float value,
+                     float weight, float amount);
+
+/**
+ * Remove the last item of a context, solved or not, in O(items). The
+ * solution is walked back again from the remaining columns.
+ *
+ * @param knapsack_context, the knapsack's context data structure.
+ * @return FALSE if it is the only item.
+ */
+bool knapsack_remove(knapsack_context* c);
+
 #include "report.h"
+#include "rolling.h"
+#include "threads.h"
+#include "pareto.h"
+#include "multi.h"
+#include "fptas.h"
+#include "branch.h"
+#include "groups.h"
 
 #endif
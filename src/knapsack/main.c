@@ -34,6 +34,18 @@ GtkFileChooser* save_dialog;
 /* Context */
 knapsack_context* c = NULL;
 
+/* Constraints beyond the weight, only loaded from files, see load(). Each
+ * item's sizes are kept in its row, rows added afterwards have none */
+#define EXTRA_SIZES_COLUMN 6
+int extra_dimensions = 0;
+int extra_capacities[KNAPSACK_DIMENSIONS];
+
+/* Weights are entered with up to two decimals, exact in fixed point */
+#define WEIGHT_SCALE 100
+
+/* Amount stored in the model for an unlimited item, shown as "oo" */
+#define UNLIMITED G_MAXINT
+
 /* Functions */
 void add_row(GtkToolButton *toolbutton, gpointer user_data);
 void remove_row(GtkToolButton *toolbutton, gpointer user_data);
@@ -47,6 +59,7 @@ void save_cb(GtkButton* button, gpointer user_data);
 void load_cb(GtkButton* button, gpointer user_data);
 void save(FILE* file);
 void load(FILE* file);
+float* row_extra_sizes(GtkTreeIter* iter);
 
 int main(int argc, char **argv)
 {
@@ -136,9 +149,10 @@ void add_row(GtkToolButton *toolbutton, gpointer user_data)
     gtk_list_store_set(items_model, &iter,
                         0, sequence_name(rows),
                         1, 1,
-                        2, 1,
+                        2, 1.0,
                         3, 1,
                         4, "1",
+                        5, "1",
                         -1);
 
     GtkTreePath* model_path = gtk_tree_model_get_path(
@@ -163,6 +177,7 @@ void remove_row(GtkToolButton *toolbutton, gpointer user_data)
     GtkTreeIter iter;
     if(gtk_tree_selection_get_selected(selection, NULL, &iter)) {
 
+        g_free(row_extra_sizes(&iter));
         bool valid = gtk_list_store_remove(items_model, &iter);
         if(!valid) {
             valid = gtk_tree_model_iter_nth_child(GTK_TREE_MODEL(items_model),
@@ -182,15 +197,16 @@ void edit_started_cb(GtkCellRenderer* renderer, GtkCellEditable* editable,
                      gchar* path, gpointer user_data)
 {
     GtkAdjustment* adj;
+    guint digits;
 
-    g_object_get(renderer, "adjustment", &adj, NULL);
+    g_object_get(renderer, "adjustment", &adj, "digits", &digits, NULL);
     if(adj) {
         g_object_unref(adj);
     }
 
     adj = gtk_adjustment_new(
                     1.00,           /* the initial value. */
-                    1.00,           /* the minimum value. */
+                    (digits > 0) ? 1.0 / WEIGHT_SCALE : 1.00, /* minimum */
                     10000000.00,    /* the maximum value. */
                     1.0,            /* the step increment. */
                     10.0,           /* the page increment. */
@@ -227,7 +243,7 @@ void cell_edited_cb(GtkCellRendererText* renderer, gchar* path,
         int is_inf = strncmp(new_text, "oo", 2);
         if(is_inf == 0 || is_empty_string(new_text)) {
             g_value_init(&value, G_TYPE_INT);
-            g_value_set_int(&value, (int) PLUS_INF);
+            g_value_set_int(&value, UNLIMITED);
             gtk_list_store_set_value(items_model, &iter, column, &value);
             g_value_unset(&value);
 
@@ -240,8 +256,26 @@ void cell_edited_cb(GtkCellRendererText* renderer, gchar* path,
         }
     }
 
-    /* Number */
+    /* Weight, rounded to the fixed point used to solve */
     char* end;
+    if(column == 2) {
+        double w = strtod(new_text, &end);
+        w = round(w * WEIGHT_SCALE) / WEIGHT_SCALE;
+        if((end != new_text) && (*end == '\0') && (w > 0.0)) {
+            g_value_init(&value, G_TYPE_FLOAT);
+            g_value_set_float(&value, (float)w);
+            gtk_list_store_set_value(items_model, &iter, column, &value);
+            g_value_unset(&value);
+
+            g_value_init(&value, G_TYPE_STRING);
+            g_value_take_string(&value, g_strdup_printf("%g", w));
+            gtk_list_store_set_value(items_model, &iter, 5, &value);
+            g_value_unset(&value);
+        }
+        return;
+    }
+
+    /* Number */
     int v = (int) strtol(new_text, &end, 10);
     if((end != new_text) && (*end == '\0') && (v > 0)) {
         g_value_init(&value, G_TYPE_INT);
@@ -265,16 +299,22 @@ void process(GtkButton* button, gpointer user_data)
         knapsack_context_free(c);
     }
 
-    /* Create context */
+    /* Create context, without tables if there are further constraints */
     int cap = gtk_spin_button_get_value_as_int(capacity);
     int num_it = gtk_tree_model_iter_n_children(
                                     GTK_TREE_MODEL(items_model), NULL);
-    c = knapsack_context_new(cap, num_it);
+    bool multi = extra_dimensions > 0;
+    if(multi) {
+        c = knapsack_context_new_compact(cap, num_it);
+    } else {
+        c = knapsack_context_new(cap, num_it);
+    }
     if(c == NULL) {
         show_error(window, "Unable to allocate enough memory for "
                            "this problem. Sorry.");
         return;
     }
+    c->scale = WEIGHT_SCALE;
 
     /* Fill context */
     item** its = c->items;
@@ -301,7 +341,7 @@ void process(GtkButton* button, gpointer user_data)
 
         gtk_tree_model_get_value(
                             GTK_TREE_MODEL(items_model), &iter, 2, &value);
-        int w = g_value_get_int(&value);
+        float w = g_value_get_float(&value);
         g_value_unset(&value);
 
         gtk_tree_model_get_value(
@@ -309,8 +349,12 @@ void process(GtkButton* button, gpointer user_data)
         int a = g_value_get_int(&value);
         g_value_unset(&value);
 
-        /* Set values */
-        item_new(its[i], n,  v, w, a); /* name, value, weight, amount */
+        /* Set values, name, value, weight, amount */
+        item_new(its[i], n,  v, w, (a == UNLIMITED) ? PLUS_INF : a);
+        float* sizes = row_extra_sizes(&iter);
+        for(int d = 0; (sizes != NULL) && (d < extra_dimensions); d++) {
+            its[i]->sizes[d + 1] = sizes[d];
+        }
 
         was_set = gtk_tree_model_iter_next(
                             GTK_TREE_MODEL(items_model), &iter);
@@ -320,17 +364,32 @@ void process(GtkButton* button, gpointer user_data)
     c->unit = g_strdup(gtk_entry_get_text(unit));
 
     /* Execute algorithm */
-    bool success = knapsack(c);
+    bool success;
+    if(multi) {
+        int capacities[KNAPSACK_DIMENSIONS];
+        capacities[0] = cap;
+        for(int d = 0; d < extra_dimensions; d++) {
+            capacities[d + 1] = extra_capacities[d];
+        }
+        success = knapsack_set_dimensions(c, extra_dimensions + 1,
+                                          capacities) &&
+                  knapsack_multi(c);
+    } else {
+        success = knapsack(c);
+    }
     if(!success) {
         show_error(window, "Error while processing the information. "
                            "Please check your data.");
+        return;
     }
 
-    /* Show tables */
-    printf("-----------------------------------\n");
-    matrix_print(c->table_values);
-    printf("-----------------------------------\n");
-    matrix_print(c->table_items);
+    /* Show tables, large instances are searched without them */
+    if(c->table_values != NULL) {
+        printf("-----------------------------------\n");
+        matrix_print(c->table_values);
+        printf("-----------------------------------\n");
+        knapsack_decisions_print(c->table_items);
+    }
 
     /* Generate report */
     bool report_created = knapsack_report(c);
@@ -482,7 +541,7 @@ void save(FILE* file)
 
         gtk_tree_model_get_value(
                             GTK_TREE_MODEL(items_model), &iter, 2, &value);
-        int w = g_value_get_int(&value);
+        float w = g_value_get_float(&value);
         g_value_unset(&value);
 
         gtk_tree_model_get_value(
@@ -496,9 +555,9 @@ void save(FILE* file)
         g_value_unset(&value);
 
         if(strncmp(as, "oo", 2) == 0) {
-            fprintf(file, "%i %i oo\n", v, w);
+            fprintf(file, "%i %g oo\n", v, w);
         } else {
-            fprintf(file, "%i %i %i\n", v, w, a);
+            fprintf(file, "%i %g %i\n", v, w, a);
         }
         g_free(as);
 
@@ -508,6 +567,29 @@ void save(FILE* file)
 
     fprintf(file, "%i\n", gtk_spin_button_get_value_as_int(capacity));
     fprintf(file, "%s\n", gtk_entry_get_text(unit));
+
+    /* Further constraints: count, capacities and a line of sizes per item */
+    if(extra_dimensions == 0) {
+        return;
+    }
+    fprintf(file, "%i\n", extra_dimensions);
+    for(int d = 0; d < extra_dimensions; d++) {
+        fprintf(file, (d == 0) ? "%i" : " %i", extra_capacities[d]);
+    }
+    fprintf(file, "\n");
+    was_set = gtk_tree_model_get_iter_first(
+                                    GTK_TREE_MODEL(items_model), &iter);
+    while(was_set) {
+        float* sizes = row_extra_sizes(&iter);
+        for(int d = 0; d < extra_dimensions; d++) {
+            fprintf(file, (d == 0) ? "%g" : " %g",
+                    (sizes != NULL) ? sizes[d] : 0.0);
+        }
+        fprintf(file, "\n");
+
+        /* Next */
+        was_set = gtk_tree_model_iter_next(GTK_TREE_MODEL(items_model), &iter);
+    }
 }
 
 void load(FILE* file)
@@ -516,7 +598,15 @@ void load(FILE* file)
     int num_items = 0;
     fscanf(file, "%i%*c", &num_items);
 
-    /* Adapt GUI */
+    /* Adapt GUI, dropping the sizes of the old items */
+    GtkTreeIter iter;
+    bool has_row = gtk_tree_model_get_iter_first(
+                            GTK_TREE_MODEL(items_model), &iter);
+    while(has_row) {
+        g_free(row_extra_sizes(&iter));
+        has_row = gtk_tree_model_iter_next(GTK_TREE_MODEL(items_model), &iter);
+    }
+    extra_dimensions = 0;
     gtk_list_store_clear(items_model);
     for(int i = 0; i < num_items; i++) {
         add_row(NULL, NULL);
@@ -529,17 +619,19 @@ void load(FILE* file)
     }
 
     /* Load items data */
-    GtkTreeIter iter;
-    bool has_row = gtk_tree_model_get_iter_first(
+    has_row = gtk_tree_model_get_iter_first(
                             GTK_TREE_MODEL(items_model), &iter);
     int v = 0;
-    int w = 0;
+    float w = 0.0;
     char buf[12];
     char* a = (char*) &buf;
+    char ws[32];
     for(int i = 0; (i < num_items) && has_row; i++) {
 
-        /* Get values */
-        fscanf(file, "%i %i %s%*c", &v, &w, a);
+        /* Get values, weights rounded to the fixed point used to solve */
+        fscanf(file, "%i %f %s%*c", &v, &w, a);
+        w = roundf(w * WEIGHT_SCALE) / WEIGHT_SCALE;
+        snprintf(ws, sizeof(ws), "%g", w);
 
         /* Set values */
         if(strncmp(a, "oo", 2) == 0) {
@@ -547,8 +639,9 @@ void load(FILE* file)
                         0, names[i],
                         1, v,
                         2, w,
-                        3, (int) PLUS_INF,
+                        3, UNLIMITED,
                         4, "oo",
+                        5, ws,
                         -1);
         } else {
             gtk_list_store_set(items_model, &iter,
@@ -557,6 +650,7 @@ void load(FILE* file)
                         2, w,
                         3, atoi(a),
                         4, a,
+                        5, ws,
                         -1);
         }
 
@@ -574,9 +668,53 @@ void load(FILE* file)
     gtk_entry_set_text(unit, u);
     free(u);
 
+    /* Further constraints, if any */
+    int dimensions = 0;
+    if((fscanf(file, "%i", &dimensions) == 1) && (dimensions > 0) &&
+       (dimensions < KNAPSACK_DIMENSIONS)) {
+        float* sizes = (float*) malloc(num_items * dimensions * sizeof(float));
+        bool read = (sizes != NULL);
+        for(int d = 0; read && (d < dimensions); d++) {
+            read = fscanf(file, "%i", &extra_capacities[d]) == 1;
+        }
+        for(int k = 0; read && (k < num_items * dimensions); k++) {
+            read = fscanf(file, "%f", &sizes[k]) == 1;
+        }
+        if(read) {
+
+            /* Store each item's sizes in its row */
+            extra_dimensions = dimensions;
+            has_row = gtk_tree_model_get_iter_first(
+                                    GTK_TREE_MODEL(items_model), &iter);
+            for(int i = 0; (i < num_items) && has_row; i++) {
+                gtk_list_store_set(items_model, &iter,
+                            EXTRA_SIZES_COLUMN,
+                            g_memdup(&sizes[i * dimensions],
+                                     dimensions * sizeof(float)),
+                            -1);
+                has_row = gtk_tree_model_iter_next(
+                                    GTK_TREE_MODEL(items_model), &iter);
+            }
+        } else {
+            show_error(window, "The further constraints of the file are "
+                               "incomplete and were ignored.");
+        }
+        free(sizes);
+    }
+
     /* Free resources */
     for(int i = 0; i < num_items; i++) {
         free(names[i]);
     }
     free(names);
 }
+
+float* row_extra_sizes(GtkTreeIter* iter)
+{
+    GValue value = G_VALUE_INIT;
+    gtk_tree_model_get_value(GTK_TREE_MODEL(items_model), iter,
+                             EXTRA_SIZES_COLUMN, &value);
+    float* sizes = (float*) g_value_get_pointer(&value);
+    g_value_unset(&value);
+    return sizes;
+}
@@ -0,0 +1,416 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "multi.h"
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+
+/**
+ * Units of an item decided together, with their size on each constraint.
+ */
+typedef struct {
+    int item;
+    int units;
+    float value;
+    long sizes[KNAPSACK_DIMENSIONS];
+} knapsack_multi_bundle;
+
+/**
+ * Grid of every capacity on every constraint, shared by the worker threads.
+ */
+typedef struct {
+    int dimensions;
+    long extents[KNAPSACK_DIMENSIONS];
+    long strides[KNAPSACK_DIMENSIONS];
+    long states;
+    long words;
+    int steps;
+    knapsack_multi_bundle* bundles;
+    float* layers[2];
+    uint64_t* taken;
+    pthread_barrier_t barrier;
+} knapsack_grid;
+
+/**
+ * Data of each worker thread.
+ */
+typedef struct {
+    knapsack_grid* g;
+    int rank;
+    int threads;
+} knapsack_grid_worker;
+
+/**
+ * Reachable state of the hashed grid.
+ */
+typedef struct {
+    gint64 index;
+    float value;
+    int parent;     /* State extended, in the previous layer */
+    bool taken;     /* If it is the parent plus the bundle */
+} knapsack_state;
+
+/* Size of an item on constraint 'd', rounded up to whole units */
+static float knapsack_multi_size(item* it, int d)
+{
+    return ceilf((d == 0) ? it->weight : it->sizes[d]);
+}
+
+/* Split every item in bundles of 1, 2, 4, ... units, returns their count */
+static int knapsack_multi_bundles(knapsack_context* c,
+                                  knapsack_multi_bundle** bundles)
+{
+    int count = 0;
+    int size = c->num_items;
+    *bundles = (knapsack_multi_bundle*) malloc(
+                                    size * sizeof(knapsack_multi_bundle));
+    if(*bundles == NULL) {
+        return -1;
+    }
+
+    for(int j = 0; j < c->num_items; j++) {
+        item* it = c->items[j];
+
+        /* Units fitting on every constraint */
+        double fit = it->amount;
+        for(int d = 0; d < c->dimensions; d++) {
+            float unit = knapsack_multi_size(it, d);
+            if(unit < 0.0) {
+                free(*bundles);
+                return -1;
+            }
+            if(unit > 0.0) {
+                fit = fmin(fit, floor((double)c->capacities[d] / unit));
+            }
+        }
+
+        /* Worthless items are never put */
+        if(it->value <= 0.0) {
+            continue;
+        }
+        if(fit >= (double)INT32_MAX) {
+            free(*bundles);
+            return -1;
+        }
+        int units = (int)fit;
+
+        for(long split = 1; units > 0; split *= 2) {
+            if(count == size) {
+                size *= 2;
+                knapsack_multi_bundle* larger = (knapsack_multi_bundle*)
+                    realloc(*bundles, size * sizeof(knapsack_multi_bundle));
+                if(larger == NULL) {
+                    free(*bundles);
+                    return -1;
+                }
+                *bundles = larger;
+            }
+            knapsack_multi_bundle* b = &(*bundles)[count];
+            b->item = j;
+            b->units = (split < units) ? (int)split : units;
+            b->value = (float)b->units * it->value;
+            for(int d = 0; d < KNAPSACK_DIMENSIONS; d++) {
+                b->sizes[d] = (d < c->dimensions) ?
+                              b->units * (long)knapsack_multi_size(it, d) : 0;
+            }
+            count++;
+            units -= b->units;
+        }
+    }
+    return count;
+}
+
+static gpointer knapsack_grid_work(gpointer data)
+{
+    knapsack_grid_worker* w = (knapsack_grid_worker*) data;
+    knapsack_grid* g = w->g;
+
+    /* Whole words of the choice bits, so no other thread writes them */
+    long from = 64 * (g->words * w->rank / w->threads);
+    long to = 64 * (g->words * (w->rank + 1) / w->threads);
+    if(to > g->states) {
+        to = g->states;
+    }
+
+    for(int s = 0; s < g->steps; s++) {
+        knapsack_multi_bundle* b = &g->bundles[s];
+        float* previous = g->layers[s % 2];
+        float* next = g->layers[(s + 1) % 2];
+        uint64_t* taken = g->taken + (s * g->words);
+
+        long offset = 0;
+        for(int d = 0; d < g->dimensions; d++) {
+            offset += b->sizes[d] * g->strides[d];
+        }
+
+        /* Coordinates of the first state, then counted up */
+        long coords[KNAPSACK_DIMENSIONS];
+        for(int d = 0; d < g->dimensions; d++) {
+            coords[d] = (from / g->strides[d]) % g->extents[d];
+        }
+
+        uint64_t bits = 0;
+        for(long state = from; state < to; state++) {
+            bool fits = true;
+            for(int d = 0; d < g->dimensions; d++) {
+                fits = fits && (coords[d] >= b->sizes[d]);
+            }
+
+            float value = previous[state];
+            if(fits) {
+                float pay = b->value + previous[state - offset];
+                if(pay > value) {
+                    value = pay;
+                    bits |= (uint64_t)1 << (state % 64);
+                }
+            }
+            next[state] = value;
+
+            if((state % 64 == 63) || (state == to - 1)) {
+                taken[state / 64] = bits;
+                bits = 0;
+            }
+            for(int d = g->dimensions - 1; d >= 0; d--) {
+                if(++coords[d] < g->extents[d]) {
+                    break;
+                }
+                coords[d] = 0;
+            }
+        }
+
+        /* Next bundle reads the whole grid */
+        pthread_barrier_wait(&g->barrier);
+    }
+    return NULL;
+}
+
+/* Solve on a grid of every capacity */
+static bool knapsack_grid_solve(knapsack_context* c, knapsack_grid* g)
+{
+    int threads = (c->threads > 1) ? c->threads : 1;
+    g->layers[0] = (float*) calloc(g->states, sizeof(float));
+    g->layers[1] = (float*) malloc(g->states * sizeof(float));
+    g->taken = (uint64_t*) malloc(((size_t)g->steps * g->words + 1) *
+                                  sizeof(uint64_t));
+    knapsack_grid_worker* workers = (knapsack_grid_worker*) malloc(
+                                    threads * sizeof(knapsack_grid_worker));
+    GThread** handles = (GThread**) malloc(threads * sizeof(GThread*));
+    if((g->layers[0] == NULL) || (g->layers[1] == NULL) ||
+       (g->taken == NULL) || (workers == NULL) || (handles == NULL)) {
+        free(g->layers[0]);
+        free(g->layers[1]);
+        free(g->taken);
+        free(workers);
+        free(handles);
+        return false;
+    }
+
+    pthread_barrier_init(&g->barrier, NULL, threads);
+    for(int t = 0; t < threads; t++) {
+        workers[t].g = g;
+        workers[t].rank = t;
+        workers[t].threads = threads;
+    }
+    for(int t = 1; t < threads; t++) {
+        handles[t] = g_thread_new("knapsack", knapsack_grid_work,
+                                  &workers[t]);
+    }
+    knapsack_grid_work(&workers[0]);
+    for(int t = 1; t < threads; t++) {
+        g_thread_join(handles[t]);
+    }
+    pthread_barrier_destroy(&g->barrier);
+
+    /* Walk back the choices from every capacity full */
+    long state = g->states - 1;
+    c->total_value = g->layers[g->steps % 2][state];
+    for(int s = g->steps - 1; s > -1; s--) {
+        knapsack_multi_bundle* b = &g->bundles[s];
+        if((g->taken[(s * g->words) + (state / 64)] >> (state % 64)) & 1) {
+            c->solution[b->item] += b->units;
+            for(int d = 0; d < g->dimensions; d++) {
+                state -= b->sizes[d] * g->strides[d];
+            }
+        }
+    }
+    c->memory_required += (2 * g->states * sizeof(float)) +
+                          (g->steps * g->words * sizeof(uint64_t));
+
+    free(g->layers[0]);
+    free(g->layers[1]);
+    free(g->taken);
+    free(workers);
+    free(handles);
+    return true;
+}
+
+/* Solve keeping only the reachable states, hashed by flattened index */
+static bool knapsack_hash_solve(knapsack_context* c, knapsack_grid* g)
+{
+    size_t size = 64;
+    int used = 1;
+    int* starts = (int*) malloc((g->steps + 2) * sizeof(int));
+    knapsack_state* states = (knapsack_state*) malloc(
+                                            size * sizeof(knapsack_state));
+    if((starts == NULL) || (states == NULL)) {
+        free(starts);
+        free(states);
+        return false;
+    }
+    states[0].index = 0;
+    states[0].value = 0.0;
+    states[0].parent = -1;
+    states[0].taken = false;
+    starts[0] = 0;
+    starts[1] = 1;
+
+    for(int s = 0; s < g->steps; s++) {
+        knapsack_multi_bundle* b = &g->bundles[s];
+        int first = starts[s];
+        int last = starts[s + 1];
+
+        /* At most twice as many states, keys don't move while hashed.
+         * States are numbered with an 'int', more can't be kept */
+        size_t needed = (size_t)used + 2 * (size_t)(last - first);
+        if(needed > INT_MAX) {
+            free(starts);
+            free(states);
+            return false;
+        }
+        if(needed > size) {
+            size = (needed > INT_MAX / 2) ? (size_t)INT_MAX : 2 * needed;
+            knapsack_state* larger = (knapsack_state*) realloc(states,
+                                            size * sizeof(knapsack_state));
+            if(larger == NULL) {
+                free(starts);
+                free(states);
+                return false;
+            }
+            states = larger;
+        }
+        GHashTable* known = g_hash_table_new(g_int64_hash, g_int64_equal);
+
+        /* Every state without the bundle, then with it if it fits */
+        for(int with = 0; with < 2; with++) {
+            for(int p = first; p < last; p++) {
+                knapsack_state next = states[p];
+                next.parent = p - first;
+                next.taken = with;
+
+                if(with) {
+                    bool fits = true;
+                    for(int d = 0; d < g->dimensions; d++) {
+                        long coord = (next.index / g->strides[d]) %
+                                     g->extents[d];
+                        fits = fits &&
+                               (coord + b->sizes[d] < g->extents[d]);
+                        next.index += b->sizes[d] * g->strides[d];
+                    }
+                    if(!fits) {
+                        continue;
+                    }
+                    next.value += b->value;
+                }
+
+                /* Keep the most valuable way to reach each state */
+                knapsack_state* seen = (knapsack_state*) g_hash_table_lookup(
+                                                        known, &next.index);
+                if(seen == NULL) {
+                    states[used] = next;
+                    g_hash_table_insert(known, &states[used].index,
+                                        &states[used]);
+                    used++;
+                } else if(next.value > seen->value) {
+                    *seen = next;
+                }
+            }
+        }
+        g_hash_table_destroy(known);
+        starts[s + 2] = used;
+    }
+
+    /* Most valuable state of the last layer, walk back its bundles */
+    int at = starts[g->steps];
+    for(int p = at + 1; p < used; p++) {
+        if(states[p].value > states[at].value) {
+            at = p;
+        }
+    }
+    c->total_value = states[at].value;
+    for(int s = g->steps - 1; s > -1; s--) {
+        if(states[at].taken) {
+            c->solution[g->bundles[s].item] += g->bundles[s].units;
+        }
+        at = starts[s] + states[at].parent;
+    }
+    c->memory_required += (size * sizeof(knapsack_state)) +
+                          ((g->steps + 2) * sizeof(int));
+
+    free(starts);
+    free(states);
+    return true;
+}
+
+bool knapsack_multi(knapsack_context* c)
+{
+    /* Start counting time */
+    GTimer* timer = g_timer_new();
+
+    knapsack_grid g;
+    g.steps = knapsack_multi_bundles(c, &g.bundles);
+    if(g.steps < 0) {
+        g_timer_destroy(timer);
+        return false;
+    }
+
+    /* Last constraint contiguous, flattened index must fit in 63 bits */
+    g.dimensions = c->dimensions;
+    g.states = 1;
+    bool representable = true;
+    for(int d = g.dimensions - 1; d >= 0; d--) {
+        g.extents[d] = (long)c->capacities[d] + 1;
+        g.strides[d] = g.states;
+        representable = representable &&
+                        (g.states <= INT64_MAX / g.extents[d]);
+        if(representable) {
+            g.states *= g.extents[d];
+        }
+    }
+    g.words = (g.states + 63) / 64;
+
+    for(int j = 0; j < c->num_items; j++) {
+        c->solution[j] = 0;
+    }
+    bool success = false;
+    if(representable) {
+        success = (g.states <= KNAPSACK_DENSE_STATES) ?
+                  knapsack_grid_solve(c, &g) :
+                  knapsack_hash_solve(c, &g);
+    }
+    c->memory_required += g.steps * sizeof(knapsack_multi_bundle);
+    free(g.bundles);
+
+    /* Stop counting time */
+    g_timer_stop(timer);
+    c->execution_time = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+    return success;
+}
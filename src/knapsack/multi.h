@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_KNAPSACK_MULTI
+#define H_KNAPSACK_MULTI
+
+#include "knapsack.h"
+
+/* Most states solved on a dense grid, beyond them states are hashed */
+#define KNAPSACK_DENSE_STATES (1 << 22)
+
+/**
+ * Perform Knapsack algorithm with several constraints.
+ *
+ * Items are measured in the context's 'dimensions' constraints, set with
+ * knapsack_set_dimensions() and item_new_sizes(), their sizes rounded up to
+ * whole units. Each item is split in bundles of 1, 2, 4, ... units and every
+ * bundle is put or not on a grid of all the capacities, flattened in one
+ * array with the last constraint contiguous. Each bundle reads the grid of
+ * the previous one, so the grid is split between 'threads' threads in
+ * contiguous ranges, that is ranges of the outermost constraint, aligned to
+ * 64 states. One bit per bundle and state records the choice to walk back
+ * the solution.
+ *
+ * If the grid would have more than KNAPSACK_DENSE_STATES states only the
+ * reachable ones are kept, hashed by their flattened index, in a single
+ * thread.
+ *
+ * Only 'solution' and 'total_value' are filled, so the context can be created
+ * with knapsack_context_new_compact().
+ *
+ * @param knapsack_context, the knapsack's context data structure.
+ * @return TRUE if execution was successful or FALSE if an item has a negative
+ *         size, an unbounded amount fits, the grid has more than 2^63 states
+ *         or memory ran out.
+ */
+bool knapsack_multi(knapsack_context* c);
+
+#endif
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pareto.h"
+
+/**
+ * Point of a frontier. Weight and value are accumulated in double precision
+ * as capacities may be beyond the integers a float holds.
+ */
+typedef struct {
+    double weight;
+    double value;
+    int parent;     /* Point extended, in the previous frontier */
+    bool taken;     /* If it is the parent plus the bundle */
+} knapsack_point;
+
+/* Make room for 'needed' more points */
+static bool knapsack_points_reserve(knapsack_point** points, int* size,
+                                    int used, int needed)
+{
+    if(used + needed <= *size) {
+        return true;
+    }
+    int grown = *size * 2;
+    if(grown < used + needed) {
+        grown = used + needed;
+    }
+    knapsack_point* larger = (knapsack_point*) realloc(*points,
+                                            grown * sizeof(knapsack_point));
+    if(larger == NULL) {
+        return false;
+    }
+    *points = larger;
+    *size = grown;
+    return true;
+}
+
+int knapsack_bundles(knapsack_context* c, knapsack_bundle** bundles)
+{
+    int count = 0;
+    int size = c->num_items;
+    *bundles = (knapsack_bundle*) malloc(size * sizeof(knapsack_bundle));
+    if(*bundles == NULL) {
+        return -1;
+    }
+
+    for(int j = 0; j < c->num_items; j++) {
+        item* it = c->items[j];
+        if(it->weight <= 0.0) {
+            free(*bundles);
+            return -1;
+        }
+
+        /* Worthless items are never put */
+        if(it->value <= 0.0) {
+            continue;
+        }
+        double fit = floor((double)c->capacity / it->weight);
+        int units = (it->amount < fit) ? (int)it->amount : (int)fit;
+
+        for(long split = 1; units > 0; split *= 2) {
+            if(count == size) {
+                size *= 2;
+                knapsack_bundle* larger = (knapsack_bundle*) realloc(
+                                    *bundles, size * sizeof(knapsack_bundle));
+                if(larger == NULL) {
+                    free(*bundles);
+                    return -1;
+                }
+                *bundles = larger;
+            }
+            int taken = (split < units) ? (int)split : units;
+            (*bundles)[count].item = j;
+            (*bundles)[count].units = taken;
+            count++;
+            units -= taken;
+        }
+    }
+    return count;
+}
+
+bool knapsack_pareto(knapsack_context* c)
+{
+    /* Start counting time */
+    GTimer* timer = g_timer_new();
+
+    knapsack_bundle* bundles = NULL;
+    int steps = knapsack_bundles(c, &bundles);
+    if(steps < 0) {
+        g_timer_destroy(timer);
+        return false;
+    }
+
+    /* Frontiers one after the other, the one after step s from starts[s] */
+    int size = 64;
+    int used = 1;
+    int* starts = (int*) malloc((steps + 2) * sizeof(int));
+    knapsack_point* points = (knapsack_point*) malloc(
+                                            size * sizeof(knapsack_point));
+    if((starts == NULL) || (points == NULL)) {
+        free(bundles);
+        free(starts);
+        free(points);
+        g_timer_destroy(timer);
+        return false;
+    }
+    points[0].weight = 0.0;
+    points[0].value = 0.0;
+    points[0].parent = -1;
+    points[0].taken = false;
+    starts[0] = 0;
+    starts[1] = 1;
+
+    for(int s = 0; s < steps; s++) {
+        int first = starts[s];
+        int last = starts[s + 1];
+        if(!knapsack_points_reserve(&points, &size, used, 2 * (last - first))) {
+            free(bundles);
+            free(starts);
+            free(points);
+            g_timer_destroy(timer);
+            return false;
+        }
+
+        item* it = c->items[bundles[s].item];
+        double weight = (double)bundles[s].units * it->weight;
+        double value = (double)bundles[s].units * it->value;
+
+        /* Merge by weight the frontier without and with the bundle */
+        int without = first;
+        int with = first;
+        while((without < last) || (with < last)) {
+
+            /* Heavier than the capacity, no more points with the bundle */
+            if((with < last) &&
+               (points[with].weight + weight > (double)c->capacity)) {
+                with = last;
+                continue;
+            }
+
+            /* Lightest first, on equal weights the most valuable */
+            bool put = (without == last);
+            if((without < last) && (with < last)) {
+                double with_weight = points[with].weight + weight;
+                double with_value = points[with].value + value;
+                put = (with_weight < points[without].weight) ||
+                      ((with_weight == points[without].weight) &&
+                       (with_value > points[without].value));
+            }
+
+            knapsack_point next;
+            if(put) {
+                next.weight = points[with].weight + weight;
+                next.value = points[with].value + value;
+                next.parent = with - first;
+                next.taken = true;
+                with++;
+            } else {
+                next = points[without];
+                next.parent = without - first;
+                next.taken = false;
+                without++;
+            }
+
+            /* Dominated by a lighter point, or as heavy and as valuable */
+            if((used > last) && (next.value <= points[used - 1].value)) {
+                continue;
+            }
+            if((used > last) && (next.weight == points[used - 1].weight)) {
+                used--;
+            }
+            points[used++] = next;
+        }
+        starts[s + 2] = used;
+    }
+
+    /* Most valuable point is the last one, walk back its bundles */
+    for(int j = 0; j < c->num_items; j++) {
+        c->solution[j] = 0;
+    }
+    int at = used - 1;
+    c->total_value = (float)points[at].value;
+    for(int s = steps - 1; s > -1; s--) {
+        if(points[at].taken) {
+            c->solution[bundles[s].item] += bundles[s].units;
+        }
+        at = starts[s] + points[at].parent;
+    }
+    c->memory_required += (size * sizeof(knapsack_point)) +
+                          ((steps + 2) * sizeof(int)) +
+                          (steps * sizeof(knapsack_bundle));
+
+    free(bundles);
+    free(starts);
+    free(points);
+
+    /* Stop counting time */
+    g_timer_stop(timer);
+    c->execution_time = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+    return true;
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_KNAPSACK_PARETO
+#define H_KNAPSACK_PARETO
+
+#include "knapsack.h"
+
+/**
+ * Units of an item decided together.
+ */
+typedef struct {
+    int item;
+    int units;
+} knapsack_bundle;
+
+/**
+ * Split every item in bundles of 1, 2, 4, ... units, up to the units
+ * available or fitting in the capacity, so any amount is a choice of
+ * bundles. Items worth nothing get no bundles.
+ *
+ * @param bundles, where to store the allocated array of bundles.
+ * @return the number of bundles, or -1 if an item has no weight or memory ran
+ *         out.
+ */
+int knapsack_bundles(knapsack_context* c, knapsack_bundle** bundles);
+
+/**
+ * Perform Knapsack algorithm keeping only the Pareto frontier.
+ *
+ * Each item is split in bundles of 1, 2, 4, ... units, so any amount up to
+ * the available one is a choice of bundles. After each bundle only the
+ * (weight, value) pairs not dominated by a lighter and more valuable one are
+ * kept, merging the previous frontier with itself shifted by the bundle in
+ * linear time. Memory depends on the number of frontier points and not on the
+ * capacity, so huge capacities can be solved with a context created by
+ * knapsack_context_new_compact(). The frontier can still grow exponentially
+ * with the number of bundles on adversarial instances.
+ *
+ * Only 'solution' and 'total_value' are filled.
+ *
+ * @param knapsack_context, the knapsack's context data structure.
+ * @return TRUE if execution was successful or FALSE if an item has no weight
+ *         or memory ran out.
+ */
+bool knapsack_pareto(knapsack_context* c);
+
+#endif
@@ -17,6 +17,18 @@
  */
 
 #include "report.h"
+#include <float.h>
+
+/* Weight given in fixed point units, with decimals only if it has any */
+static void knapsack_weight(FILE* stream, long units, int scale)
+{
+    float weight = (float)units / scale;
+    if(units % scale == 0) {
+        fprintf(stream, "%.0f", weight);
+    } else {
+        fprintf(stream, "%.2f", weight);
+    }
+}
 
 bool knapsack_report(knapsack_context* c)
 {
@@ -81,24 +93,35 @@ bool knapsack_report(knapsack_context* c)
     fprintf(report, "\\subsection{%s}\n", "Analisis");
     fprintf(report, "\\begin{compactitem}\n");
 
-    int capacity_left = c->capacity;
+    /* Weights are added in fixed point, exactly for the multiples of
+     * 1 / scale, rounding the others up as the tables do */
+    long capacity_left = (long)c->capacity * c->scale;
     int total_items = 0;
-    matrix* ti = c->table_items;
+    bool grouped = knapsack_is_grouped(c);
 
-    for(int at_item = ti->columns - 1; at_item > -1; at_item--) {
+    for(int at_item = c->num_items - 1; at_item > -1; at_item--) {
 
-        int put_items = (int)ti->data[capacity_left][at_item];
+        int put_items = c->solution[at_item];
         if(put_items == 0) {
             continue;
         }
         item* citem = c->items[at_item];
-        int capacity_took = (int)ceilf((float)put_items * citem->weight);
+        float units = citem->weight * c->scale;
+        long capacity_took = put_items * lroundf(units);
+        if(fabsf(units - rintf(units)) > units * FLT_EPSILON) {
+            capacity_took = (long)ceilf((float)put_items * citem->weight) *
+                            c->scale;
+        }
         float value_added = put_items * citem->value;
 
         fprintf(report, "\\item %s {\\Large %s} : %s {\\Large %i}. \n",
                         "Item", citem->name, "put", put_items);
 
         fprintf(report, "    \\begin{compactitem}\n");
+        if(grouped) {
+            fprintf(report, "    \\item %s : {\\Large %i}. \n",
+                            "Group", citem->group);
+        }
         if(floorf(value_added) == value_added) {
             fprintf(report, "    \\item %s : {\\Large %.0f}. \n",
                             "Accumulated value", value_added);
@@ -106,8 +129,9 @@ bool knapsack_report(knapsack_context* c)
             fprintf(report, "    \\item %s : {\\Large %.2f}. \n",
                             "Accumulated value", value_added);
         }
-        fprintf(report, "    \\item %s : {\\Large %i}. \n",
-                        "Accumulated weight", capacity_took);
+        fprintf(report, "    \\item %s : {\\Large ", "Accumulated weight");
+        knapsack_weight(report, capacity_took, c->scale);
+        fprintf(report, "}. \n");
         fprintf(report, "    \\end{compactitem}\n");
 
         fprintf(report, "\n");
@@ -119,15 +143,14 @@ bool knapsack_report(knapsack_context* c)
     fprintf(report, "\n");
 
     /* Write digest */
-    matrix* tv = c->table_values;
     fprintf(report, "\\subsection{%s}\n", "Digest");
     fprintf(report, "\\begin{compactitem}\n");
     fprintf(report, "    \\item %s : {\\Large %i}. \n",
-                    "Total accumulated value",
-                    (int)tv->data[tv->rows - 1][tv->columns - 1]);
-    fprintf(report, "    \\item %s : {\\Large %i/%i}. \n",
-                    "Total accumulated weight",
-                    c->capacity - capacity_left, c->capacity);
+                    "Total accumulated value", (int)c->total_value);
+    fprintf(report, "    \\item %s : {\\Large ", "Total accumulated weight");
+    knapsack_weight(report, (long)c->capacity * c->scale - capacity_left,
+                    c->scale);
+    fprintf(report, "/%i}. \n", c->capacity);
     fprintf(report, "    \\item %s : {\\Large %i}. \n",
                     "Total items", total_items);
     fprintf(report, "\\end{compactitem}\n");
@@ -153,19 +176,29 @@ bool knapsack_report(knapsack_context* c)
 
 void knapsack_items(knapsack_context* c, FILE* stream)
 {
+    /* Groups in one more column, if any */
+    bool grouped = knapsack_is_grouped(c);
+
     /* Table preamble */
     fprintf(stream, "\\begin{table}[!ht]\n");
     fprintf(stream, "\\begin{adjustwidth}{-3cm}{-3cm}\n");
     fprintf(stream, "\\centering\n");
     fprintf(stream, "\\begin{tabular}{c||c|c|c|c|");
-    fprintf(stream, "}\n\\cline{2-5}\n");
+    if(grouped) {
+        fprintf(stream, "c|");
+    }
+    fprintf(stream, "}\n\\cline{2-%i}\n", grouped ? 6 : 5);
 
     /* Table headers */
     fprintf(stream, " & \\cellcolor{gray90}\\textbf{%s}"
                     " & \\cellcolor{gray90}\\textbf{%s}"
                     " & \\cellcolor{gray90}\\textbf{%s}"
-                    " & \\cellcolor{gray90}\\textbf{%s} \\\\\n",
+                    " & \\cellcolor{gray90}\\textbf{%s}",
                     "Name", "Value", "Weight", "Amount");
+    if(grouped) {
+        fprintf(stream, " & \\cellcolor{gray90}\\textbf{%s}", "Group");
+    }
+    fprintf(stream, " \\\\\n");
     fprintf(stream, "\\hline\\hline\n");
 
     /* Table body */
@@ -198,6 +231,9 @@ void knapsack_items(knapsack_context* c, FILE* stream)
                 fprintf(stream, " & ");
             }
         }
+        if(grouped) {
+            fprintf(stream, " & %i", c->items[i]->group);
+        }
         fprintf(stream, " \\\\ \\hline\n");
     }
 
@@ -212,6 +248,14 @@ void knapsack_table(knapsack_context* c, FILE* stream)
 {
     matrix* m = c->table_values;
 
+    /* Some engines don't keep the tables */
+    if((m == NULL) || (c->table_items == NULL)) {
+        fprintf(stream, "%s.\n", "The tables were not stored for this "
+                                 "execution");
+        fprintf(stream, "\n");
+        return;
+    }
+
     /* Table preamble */
     fprintf(stream, "\\begin{table}[!ht]\n");
     fprintf(stream, "\\begin{adjustwidth}{-3cm}{-3cm}\n");
@@ -240,12 +284,25 @@ void knapsack_table(knapsack_context* c, FILE* stream)
 
     /* Table body */
     for(int i = 0; i < m->rows; i++) {
-        fprintf(stream, "\\multicolumn{1}{|c||}"
-                        "{\\cellcolor{gray90}\\textbf{%i}} & ", i);
+
+        /* Capacity of the row, in fixed point when the weights are */
+        float capacity = (float)i;
+        if(c->divisor != 0) {
+            capacity = (float)i * c->divisor / c->scale;
+        }
+        if(ceilf(capacity) == capacity) {
+            fprintf(stream, "\\multicolumn{1}{|c||}"
+                            "{\\cellcolor{gray90}\\textbf{%.0f}} & ",
+                            capacity);
+        } else {
+            fprintf(stream, "\\multicolumn{1}{|c||}"
+                            "{\\cellcolor{gray90}\\textbf{%.2f}} & ",
+                            capacity);
+        }
         for(int j = 0; j < m->columns; j++) {
 
             float cell = m->data[i][j];
-            float amount = c->table_items->data[i][j];
+            float amount = (float)knapsack_decision(c->table_items, i, j);
 
             /* Value */
             if(cell == FLT_MAX) {
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <limits.h>
+#include "rolling.h"
+
+/* Best value of items [first, last) for every capacity up to 'capacity' */
+static void knapsack_sweep(knapsack_context* c, int first, int last,
+                           int capacity, float* best)
+{
+    for(int i = 0; i <= capacity; i++) {
+        best[i] = 0.0;
+    }
+
+    for(int j = first; j < last; j++) {
+        item* it = c->items[j];
+        if(it->weight <= 0.0) {
+            continue;
+        }
+
+        /* As many as fit, upwards so smaller capacities already hold it */
+        int weight = (int)it->weight;
+        if((it->weight >= 1.0) && (it->weight == (float)weight) &&
+           (it->amount >= floorf((float)capacity / it->weight))) {
+            for(int i = weight; i <= capacity; i++) {
+                float pay = it->value + best[i - weight];
+                if(pay > best[i]) {
+                    best[i] = pay;
+                }
+            }
+            continue;
+        }
+
+        /* Downwards, so smaller capacities still hold the previous item */
+        for(int i = capacity; i >= 0; i--) {
+            int q = fminf(it->amount, floorf((float)i / it->weight));
+            float value = best[i];
+            for(int times = 1; times < q + 1; times++) {
+                float pay = (float)times * it->value;
+                int prev_row = (int) floorf((float)i - (times * it->weight));
+                if(prev_row >= 0) {
+                    pay += best[prev_row];
+                }
+                if(pay > value) {
+                    value = pay;
+                }
+            }
+            best[i] = value;
+        }
+    }
+}
+
+static void knapsack_split(knapsack_context* c, int first, int last,
+                           int capacity, float* left, float* right)
+{
+    /* Single item, put as many as fit */
+    if(last - first == 1) {
+        item* it = c->items[first];
+        if(it->weight <= 0.0) {
+            return;
+        }
+        int q = fminf(it->amount, floorf((float)capacity / it->weight));
+        c->solution[first] = (it->value > 0.0) ? q : 0;
+        return;
+    }
+
+    /* Nothing fits */
+    if(capacity == 0) {
+        for(int j = first; j < last; j++) {
+            if(c->items[j]->weight > 0.0) {
+                c->solution[j] = 0;
+            }
+        }
+        return;
+    }
+
+    /* Best split of the capacity between both halves */
+    int middle = (first + last) / 2;
+    knapsack_sweep(c, first, middle, capacity, left);
+    knapsack_sweep(c, middle, last, capacity, right);
+
+    int split = 0;
+    float best = left[0] + right[capacity];
+    for(int s = 1; s <= capacity; s++) {
+        float value = left[s] + right[capacity - s];
+        if(value > best) {
+            best = value;
+            split = s;
+        }
+    }
+
+    knapsack_split(c, first, middle, split, left, right);
+    knapsack_split(c, middle, last, capacity - split, left, right);
+}
+
+bool knapsack_rolling(knapsack_context* c)
+{
+    /* Weightless items are always put whole, unlimited ones can't be */
+    for(int j = 0; j < c->num_items; j++) {
+        item* it = c->items[j];
+        if(it->weight > 0.0) {
+            continue;
+        }
+        if((it->value > 0.0) && (it->amount >= (float)INT_MAX)) {
+            return false;
+        }
+        c->solution[j] = (it->value > 0.0) ? (int)it->amount : 0;
+    }
+
+    /* Start counting time */
+    GTimer* timer = g_timer_new();
+
+    /* Try to allocate the two capacity arrays */
+    float* left = (float*) malloc((c->capacity + 1) * sizeof(float));
+    float* right = (float*) malloc((c->capacity + 1) * sizeof(float));
+    if((left == NULL) || (right == NULL)) {
+        free(left);
+        free(right);
+        g_timer_destroy(timer);
+        return false;
+    }
+    c->memory_required += 2 * (c->capacity + 1) * sizeof(float);
+
+    knapsack_split(c, 0, c->num_items, c->capacity, left, right);
+
+    /* Accumulated value of the solution */
+    c->total_value = 0.0;
+    for(int j = 0; j < c->num_items; j++) {
+        c->total_value += c->solution[j] * c->items[j]->value;
+    }
+
+    free(left);
+    free(right);
+
+    /* Stop counting time */
+    g_timer_stop(timer);
+    c->execution_time = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+    return true;
+}
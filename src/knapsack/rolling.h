@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_KNAPSACK_ROLLING
+#define H_KNAPSACK_ROLLING
+
+#include "knapsack.h"
+
+/**
+ * Perform Knapsack algorithm in O(capacity) memory.
+ *
+ * Items are swept one at a time over a single array of capacities. The
+ * amount put of each item is recovered by divide and conquer: two sweeps find
+ * how the capacity is best split between the first and the second half of the
+ * items, and each half is then solved recursively with its share, reusing the
+ * same two arrays. Only 'solution' and 'total_value' are filled, so the
+ * context can be created with knapsack_context_new_compact(). Weightless items
+ * are put whole before the sweep, so an unlimited one worth something fails.
+ *
+ * @param knapsack_context, the knapsack's context data structure.
+ * @return TRUE if execution was successful or FALSE if and error ocurred.
+ */
+bool knapsack_rolling(knapsack_context* c);
+
+#endif
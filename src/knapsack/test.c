@@ -17,8 +17,858 @@
  */
 
 #include "knapsack.h"
+#include "kernels.h"
 #include "latex.h"
 
+/* Fill the context with random items */
+static void random_items(knapsack_context* c)
+{
+    for(int j = 0; j < c->num_items; j++) {
+        item_new(c->items[j], "X", rand() % 20, 1 + rand() % 9,
+                 1 + rand() % 4);
+    }
+}
+
+/* Check the tables against trying every amount of every item, for every
+ * kind of instance knapsack() has a dedicated kernel */
+static bool test_bounded(int trials)
+{
+    for(int t = 0; t < trials; t++) {
+        int capacity = 1 + rand() % 200;
+        int num_items = 1 + rand() % 10;
+
+        knapsack_context* c = knapsack_context_new(capacity, num_items);
+        if(c == NULL) {
+            return false;
+        }
+        /* Bounded, unbounded and subset sum instances */
+        for(int j = 0; j < num_items; j++) {
+            int weight = 1 + rand() % 9;
+            if(t % 3 == 0) {
+                item_new(c->items[j], "X", rand() % 20, weight,
+                         1 + rand() % 100);
+            } else if(t % 3 == 1) {
+                item_new(c->items[j], "X", rand() % 20, weight, 1000);
+            } else {
+                weight = 1 + rand() % 70;
+                item_new(c->items[j], "X", weight, weight, 1);
+            }
+        }
+        if(!knapsack(c)) {
+            return false;
+        }
+
+        /* Reference tables, first row (previous column) is all zeros */
+        matrix* ref = matrix_new(capacity + 1, num_items + 1, 0.0);
+        bool same = (ref != NULL);
+        for(int j = 0; same && (j < num_items); j++) {
+            item* it = c->items[j];
+            for(int i = 0; i <= capacity; i++) {
+                int taken = 0;
+                float value = ref->data[i][j];
+                int q = fminf(it->amount, floorf((float)i / it->weight));
+                for(int times = 1; times < q + 1; times++) {
+                    int prev_row = i - (times * (int)it->weight);
+                    float pay = (float)times * it->value +
+                                ref->data[prev_row][j];
+                    if(pay > value) {
+                        value = pay;
+                        taken = times;
+                    }
+                }
+                ref->data[i][j + 1] = value;
+                int row = knapsack_row(c, i);
+                same = same && (c->table_values->data[row][j] == value) &&
+                       (knapsack_decision(c->table_items, row, j) == taken);
+            }
+        }
+        matrix_free(ref);
+        knapsack_context_free(c);
+
+        if(!same) {
+            printf("Bounded tables differ on trial %i.\n", t);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Fill the context with items of every kernel kind */
+static void mixed_items(knapsack_context* c)
+{
+    for(int j = 0; j < c->num_items; j++) {
+        float value = (rand() % 200) / 8.0;
+        switch(rand() % 3) {
+            case 0:
+                item_new(c->items[j], "X", value, 1 + rand() % 9,
+                         1 + rand() % 5);
+                break;
+            case 1:
+                item_new(c->items[j], "X", value, 1 + rand() % 9, 10000);
+                break;
+            default:
+                item_new(c->items[j], "X", value, (1 + rand() % 40) / 4.0,
+                         1 + rand() % 5);
+        }
+    }
+}
+
+/* Check tables are equal on the first 'columns' items, at every capacity
+ * whatever rows hold them */
+static bool same_tables(knapsack_context* a, knapsack_context* b, int columns)
+{
+    size_t row = columns * sizeof(float);
+    for(int i = 0; i <= a->capacity; i++) {
+        int ra = knapsack_row(a, i);
+        int rb = knapsack_row(b, i);
+        if(memcmp(a->table_values->data[ra], b->table_values->data[rb],
+                  row) != 0) {
+            return false;
+        }
+        for(int j = 0; j < columns; j++) {
+            if(knapsack_decision(a->table_items, ra, j) !=
+               knapsack_decision(b->table_items, rb, j)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* Check threaded tables are bit-identical to the serial ones */
+static bool test_threads(int trials)
+{
+    for(int t = 0; t < trials; t++) {
+        int capacity = 1 + rand() % 300;
+        int num_items = 1 + rand() % 12;
+        int threads = 2 + t % 7;
+
+        knapsack_context* serial = knapsack_context_new(capacity, num_items);
+        knapsack_context* parallel = knapsack_context_new(capacity,
+                                                          num_items);
+        if((serial == NULL) || (parallel == NULL)) {
+            return false;
+        }
+        mixed_items(serial);
+        for(int j = 0; (j < num_items) && (t % 2 == 1); j += 2) {
+            /* Heavier than a thread's rows, read in separate windows */
+            item_new(serial->items[j], "X", (rand() % 200) / 8.0,
+                     20 + rand() % 60, 1 + rand() % 3);
+        }
+        for(int j = 0; j < num_items; j++) {
+            *parallel->items[j] = *serial->items[j];
+        }
+        parallel->threads = threads;
+
+        if(!knapsack(serial) || !knapsack(parallel)) {
+            return false;
+        }
+
+        bool same = same_tables(serial, parallel, num_items);
+        knapsack_context_free(serial);
+        knapsack_context_free(parallel);
+
+        if(!same) {
+            printf("Threaded tables differ on trial %i with %i threads.\n",
+                   t, threads);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Show how the threaded tables scale */
+static void bench_threads(int capacity, int num_items)
+{
+    knapsack_context* c = knapsack_context_new(capacity, num_items);
+    if(c == NULL) {
+        return;
+    }
+    mixed_items(c);
+    for(int threads = 1; threads <= 64; threads *= 2) {
+        c->threads = threads;
+        knapsack(c);
+        printf("%2i threads: %.4f s\n", threads, c->execution_time);
+    }
+    knapsack_context_free(c);
+}
+
+/* Time the shifted columns kernel against the scalar loop, same tables */
+static bool bench_shifts(int capacity, int num_items)
+{
+    knapsack_context* scalar = knapsack_context_new(capacity, num_items);
+    knapsack_context* shifts = knapsack_context_new(capacity, num_items);
+    knapsack_kind* kinds = (knapsack_kind*) malloc(
+                                        num_items * sizeof(knapsack_kind));
+    if((scalar == NULL) || (shifts == NULL) || (kinds == NULL)) {
+        return false;
+    }
+    for(int j = 0; j < num_items; j++) {
+        item_new(scalar->items[j], "X", (rand() % 200) / 8.0,
+                 1 + rand() % 500, 1 + rand() % 4);
+        *shifts->items[j] = *scalar->items[j];
+        kinds[j] = KNAPSACK_ANY;
+    }
+    if(!knapsack_layout(scalar) || !knapsack_layout(shifts)) {
+        return false;
+    }
+    float* scratch = (float*) malloc(
+                knapsack_shifts_scratch(shifts, KNAPSACK_BLOCK) * sizeof(float));
+    if(scratch == NULL) {
+        return false;
+    }
+
+    GTimer* timer = g_timer_new();
+    knapsack_rows(scalar, kinds, 0, num_items, 0, capacity + 1);
+    double scalar_time = g_timer_elapsed(timer, NULL);
+    g_timer_start(timer);
+    for(int from = 0; from <= capacity; from += KNAPSACK_BLOCK) {
+        int to = (from + KNAPSACK_BLOCK <= capacity) ?
+                 from + KNAPSACK_BLOCK : capacity + 1;
+        for(int j = 0; j < num_items; j++) {
+            knapsack_shifts(shifts, j, scratch, from, to);
+        }
+    }
+    double shifts_time = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+    printf("Scalar loop: %.4f s, shifted columns: %.4f s\n",
+           scalar_time, shifts_time);
+
+    bool same = same_tables(scalar, shifts, num_items);
+
+    free(kinds);
+    free(scratch);
+    knapsack_context_free(scalar);
+    knapsack_context_free(shifts);
+    return same;
+}
+
+/* Check a solution fits and its value is the total value */
+static bool valid_solution(knapsack_context* c)
+{
+    double weight = 0.0;
+    double value = 0.0;
+    for(int j = 0; j < c->num_items; j++) {
+        int put = c->solution[j];
+        if((put < 0) || (put > c->items[j]->amount)) {
+            return false;
+        }
+        weight += put * (double)c->items[j]->weight;
+        value += put * (double)c->items[j]->value;
+    }
+    return (weight <= c->capacity) && ((float)value == c->total_value);
+}
+
+/* Check the approximation error and show its runtime against epsilon */
+static bool test_fptas(int trials)
+{
+    float epsilons[] = {0.5, 0.2, 0.1, 0.05};
+
+    for(int t = 0; t < trials; t++) {
+        int capacity = 100 + rand() % 1000;
+        int num_items = 1 + rand() % 40;
+        float epsilon = epsilons[t % 4];
+
+        knapsack_context* full = knapsack_context_new(capacity, num_items);
+        knapsack_context* compact = knapsack_context_new_compact(capacity,
+                                                                 num_items);
+        if((full == NULL) || (compact == NULL)) {
+            return false;
+        }
+        for(int j = 0; j < num_items; j++) {
+            item_new(full->items[j], "X", rand() % 10000, 1 + rand() % 100,
+                     1 + rand() % 5);
+            *compact->items[j] = *full->items[j];
+        }
+
+        bool close = knapsack(full) && knapsack_fptas(compact, epsilon) &&
+                     valid_solution(compact) &&
+                     (compact->total_value >=
+                      (1.0 - epsilon) * full->total_value);
+        knapsack_context_free(full);
+        knapsack_context_free(compact);
+
+        if(!close) {
+            printf("Approximation out of bounds on trial %i.\n", t);
+            return false;
+        }
+    }
+
+    /* Runtime on a large item set */
+    knapsack_context* c = knapsack_context_new_compact(1000000, 200);
+    if(c == NULL) {
+        return false;
+    }
+    for(int j = 0; j < c->num_items; j++) {
+        item_new(c->items[j], "X", rand() % 1000000, 1 + rand() % 100000,
+                 1 + rand() % 3);
+    }
+    for(int e = 0; e < 4; e++) {
+        if(!knapsack_fptas(c, epsilons[e])) {
+            return false;
+        }
+        printf("Epsilon %.2f: %.4f s, value %.0f\n", epsilons[e],
+               c->execution_time, c->total_value);
+    }
+    knapsack_context_free(c);
+    return true;
+}
+
+/* Check queries on one solve against solving every capacity again */
+static bool test_queries(int trials)
+{
+    for(int t = 0; t < trials; t++) {
+        int capacity = 1 + rand() % 100;
+        int num_items = 1 + rand() % 10;
+
+        knapsack_context* c = knapsack_context_new(capacity, num_items);
+        if(c == NULL) {
+            return false;
+        }
+        random_items(c);
+        if(!knapsack(c)) {
+            return false;
+        }
+
+        /* Values in one batch */
+        int* capacities = (int*) malloc((capacity + 1) * sizeof(int));
+        float* values = (float*) malloc((capacity + 1) * sizeof(float));
+        if((capacities == NULL) || (values == NULL)) {
+            return false;
+        }
+        for(int k = 0; k <= capacity; k++) {
+            capacities[k] = capacity - k;
+        }
+        bool same = knapsack_query_batch(c, capacity + 1, capacities,
+                                         values);
+        same = same && !knapsack_query(c, capacity + 1, values, NULL);
+
+        for(int k = 1; same && (k <= capacity); k++) {
+            knapsack_context* again = knapsack_context_new(k, num_items);
+            if(again == NULL) {
+                return false;
+            }
+            for(int j = 0; j < num_items; j++) {
+                *again->items[j] = *c->items[j];
+            }
+            knapsack(again);
+
+            /* Solution of the query, checked as if it was a solve */
+            float value;
+            same = knapsack_query(c, k, &value, again->solution) &&
+                   (value == again->total_value) &&
+                   (values[capacity - k] == value) &&
+                   valid_solution(again);
+            knapsack_context_free(again);
+        }
+
+        free(capacities);
+        free(values);
+        knapsack_context_free(c);
+        if(!same) {
+            printf("Queries differ on trial %i.\n", t);
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/* Check appending and removing items against solving from scratch */
+static bool test_incremental(int trials)
+{
+    for(int t = 0; t < trials; t++) {
+        int capacity = 1 + rand() % 300;
+        int num_items = 2 + rand() % 20;
+
+        knapsack_context* full = knapsack_context_new(capacity, num_items);
+        knapsack_context* grown = knapsack_context_new(capacity, 1);
+        if((full == NULL) || (grown == NULL)) {
+            return false;
+        }
+        mixed_items(full);
+        *grown->items[0] = *full->items[0];
+        knapsack(grown);
+        knapsack(full);
+
+        bool same = true;
+        for(int j = 1; same && (j < num_items); j++) {
+            item* it = full->items[j];
+            same = knapsack_append(grown, it->name, it->value, it->weight,
+                                   it->amount);
+        }
+        same = same && (grown->num_items == num_items) &&
+               (grown->total_value == full->total_value) &&
+               same_tables(full, grown, num_items);
+
+        /* Removing goes back to the tables of fewer items */
+        int removed = rand() % num_items;
+        for(int r = 0; same && (r < removed); r++) {
+            same = knapsack_remove(grown);
+        }
+        if(same) {
+            float value;
+            int* solution = (int*) malloc(num_items * sizeof(int));
+            knapsack_context* prefix = knapsack_context_new(capacity,
+                                                   num_items - removed);
+            for(int j = 0; j < num_items - removed; j++) {
+                *prefix->items[j] = *full->items[j];
+            }
+            knapsack(prefix);
+            same = knapsack_query(grown, capacity, &value, solution) &&
+                   (value == prefix->total_value) &&
+                   (grown->total_value == prefix->total_value) &&
+                   (memcmp(grown->solution, prefix->solution,
+                           prefix->num_items * sizeof(int)) == 0) &&
+                   same_tables(prefix, grown, prefix->num_items);
+            knapsack_context_free(prefix);
+            free(solution);
+        }
+        knapsack_context_free(full);
+        knapsack_context_free(grown);
+
+        if(!same) {
+            printf("Incremental tables differ on trial %i.\n", t);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Check the frontier engine against the tables, and on a huge capacity */
+static bool test_pareto(int trials)
+{
+    for(int t = 0; t < trials; t++) {
+        int capacity = 1 + rand() % 300;
+        int num_items = 1 + rand() % 12;
+
+        knapsack_context* full = knapsack_context_new(capacity, num_items);
+        knapsack_context* compact = knapsack_context_new_compact(capacity,
+                                                                 num_items);
+        if((full == NULL) || (compact == NULL)) {
+            return false;
+        }
+        mixed_items(full);
+        bool integral = true;
+        for(int j = 0; j < num_items; j++) {
+            *compact->items[j] = *full->items[j];
+            integral = integral &&
+                       (floorf(full->items[j]->weight) ==
+                        full->items[j]->weight);
+        }
+
+        if(!knapsack(full) || !knapsack_pareto(compact)) {
+            return false;
+        }
+
+        /* Tables round fractional weights up when combined */
+        bool same = valid_solution(compact) &&
+                    (integral ? (compact->total_value == full->total_value)
+                              : (compact->total_value >= full->total_value));
+        knapsack_context_free(full);
+        knapsack_context_free(compact);
+
+        if(!same) {
+            printf("Frontier engine differs on trial %i.\n", t);
+            return false;
+        }
+    }
+
+    knapsack_context* c = knapsack_context_new_compact(2000000000, 40);
+    if(c == NULL) {
+        return false;
+    }
+    for(int j = 0; j < c->num_items; j++) {
+        item_new(c->items[j], "X", 1 + rand() % 1000,
+                 1000000 + rand() % 100000000, 1 + rand() % 50);
+    }
+    bool solved = knapsack_pareto(c) && valid_solution(c);
+    printf("Capacity %i solved in %.4f s with %u bytes.\n",
+           c->capacity, c->execution_time, c->memory_required);
+    knapsack_context_free(c);
+    return solved;
+}
+
+/* Best value trying every amount of items [j, num_items) */
+static float brute_force(knapsack_context* c, int j, int* left)
+{
+    if(j == c->num_items) {
+        return 0.0;
+    }
+    item* it = c->items[j];
+    float best = 0.0;
+    for(int put = 0; put <= it->amount; put++) {
+        bool fits = true;
+        for(int d = 0; d < c->dimensions; d++) {
+            fits = fits && (put * ceilf(it->sizes[d]) <= left[d]);
+        }
+        if(!fits) {
+            break;
+        }
+        for(int d = 0; d < c->dimensions; d++) {
+            left[d] -= put * ceilf(it->sizes[d]);
+        }
+        float value = put * it->value + brute_force(c, j + 1, left);
+        for(int d = 0; d < c->dimensions; d++) {
+            left[d] += put * ceilf(it->sizes[d]);
+        }
+        if(value > best) {
+            best = value;
+        }
+    }
+    return best;
+}
+
+/* Check several constraints on the grid and hashed against brute force */
+static bool test_multi(int trials)
+{
+    for(int t = 0; t < trials; t++) {
+        int dimensions = 1 + rand() % KNAPSACK_DIMENSIONS;
+        int num_items = 1 + rand() % 6;
+        int capacities[KNAPSACK_DIMENSIONS];
+
+        /* Every other trial is too large for the grid */
+        int range = (t % 2 == 0) ? 20 : 5000;
+        for(int d = 0; d < dimensions; d++) {
+            capacities[d] = 1 + rand() % range;
+        }
+        knapsack_context* c = knapsack_context_new_compact(capacities[0],
+                                                           num_items);
+        if((c == NULL) ||
+           !knapsack_set_dimensions(c, dimensions, capacities)) {
+            return false;
+        }
+        c->threads = 1 + t % 4;
+        for(int j = 0; j < num_items; j++) {
+            float sizes[KNAPSACK_DIMENSIONS];
+            for(int d = 0; d < dimensions; d++) {
+                sizes[d] = rand() % (range / 2);
+            }
+            item_new_sizes(c->items[j], "X", 1 + rand() % 20, dimensions,
+                           sizes, 1 + rand() % 3);
+        }
+        if(!knapsack_multi(c)) {
+            return false;
+        }
+
+        /* Same value as brute force, solution fits and is worth it */
+        int left[KNAPSACK_DIMENSIONS];
+        memcpy(left, capacities, sizeof(left));
+        bool same = (brute_force(c, 0, left) == c->total_value);
+        float value = 0.0;
+        for(int j = 0; j < num_items; j++) {
+            value += c->solution[j] * c->items[j]->value;
+            same = same && (c->solution[j] <= c->items[j]->amount);
+            for(int d = 0; d < dimensions; d++) {
+                left[d] -= c->solution[j] * ceilf(c->items[j]->sizes[d]);
+            }
+        }
+        for(int d = 0; d < dimensions; d++) {
+            same = same && (left[d] >= 0);
+        }
+        same = same && (value == c->total_value);
+        knapsack_context_free(c);
+
+        if(!same) {
+            printf("Several constraints differ on trial %i.\n", t);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Check the rolling engine against the tables on random knapsacks */
+static bool test_rolling(int trials)
+{
+    for(int t = 0; t < trials; t++) {
+        int capacity = 1 + rand() % 60;
+        int num_items = 1 + rand() % 12;
+
+        knapsack_context* full = knapsack_context_new(capacity, num_items);
+        knapsack_context* compact = knapsack_context_new_compact(capacity,
+                                                                 num_items);
+        if((full == NULL) || (compact == NULL)) {
+            return false;
+        }
+        random_items(full);
+        for(int j = 0; j < num_items; j++) {
+            *compact->items[j] = *full->items[j];
+        }
+
+        if(!knapsack(full) || !knapsack_rolling(compact)) {
+            return false;
+        }
+
+        /* Same value with a feasible solution */
+        float weight = 0.0;
+        bool valid = (full->total_value == compact->total_value);
+        for(int j = 0; j < num_items; j++) {
+            int put = compact->solution[j];
+            valid = valid && (put >= 0) && (put <= compact->items[j]->amount);
+            weight += put * compact->items[j]->weight;
+        }
+        valid = valid && (weight <= capacity);
+
+        knapsack_context_free(full);
+        knapsack_context_free(compact);
+
+        if(!valid) {
+            printf("Rolling engine differs on trial %i.\n", t);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Check that the rolling engine puts weightless items whole */
+static bool test_rolling_weightless()
+{
+    knapsack_context* c = knapsack_context_new_compact(10, 3);
+    if(c == NULL) {
+        return false;
+    }
+    item_new(c->items[0], "X", 5, 0, 3);
+    item_new(c->items[1], "X", 7, 4, 2);
+    item_new(c->items[2], "X", 0, 0, 4);
+
+    bool valid = knapsack_rolling(c) &&
+                 (c->solution[0] == 3) && (c->solution[1] == 2) &&
+                 (c->solution[2] == 0) && (c->total_value == 29.0);
+
+    /* Unlimited and worth something can't be put whole */
+    c->items[0]->amount = INFINITY;
+    valid = valid && !knapsack_rolling(c);
+
+    knapsack_context_free(c);
+    return valid;
+}
+
+/* Check branch and bound against the tables, and as the fallback */
+static bool test_branch(int trials)
+{
+    for(int t = 0; t < trials; t++) {
+        int capacity = 1 + rand() % 300;
+        int num_items = 1 + rand() % 12;
+
+        knapsack_context* full = knapsack_context_new(capacity, num_items);
+        knapsack_context* compact = knapsack_context_new_compact(capacity,
+                                                                 num_items);
+        if((full == NULL) || (compact == NULL)) {
+            return false;
+        }
+        mixed_items(full);
+        bool integral = true;
+        for(int j = 0; j < num_items; j++) {
+            *compact->items[j] = *full->items[j];
+            integral = integral &&
+                       (floorf(full->items[j]->weight) ==
+                        full->items[j]->weight);
+        }
+
+        if(!knapsack(full) || !knapsack(compact)) {
+            return false;
+        }
+
+        /* Tables round fractional weights up when combined */
+        bool same = valid_solution(compact) &&
+                    (integral ? (compact->total_value == full->total_value)
+                              : (compact->total_value >= full->total_value));
+        knapsack_context_free(full);
+        knapsack_context_free(compact);
+
+        if(!same) {
+            printf("Branch and bound differs on trial %i.\n", t);
+            return false;
+        }
+    }
+
+    /* Tables beyond the budget are not allocated */
+    knapsack_context* c = knapsack_context_new(200000000, 10);
+    if(c == NULL) {
+        return false;
+    }
+    for(int j = 0; j < c->num_items; j++) {
+        item_new(c->items[j], "X", 1 + rand() % 1000,
+                 1000000 + rand() % 10000000, 1 + rand() % 50);
+    }
+    item_new(c->items[0], "X", 1, 1000001, 1);
+    bool solved = knapsack(c) && (c->table_values == NULL) &&
+                  valid_solution(c);
+    printf("Capacity %i searched in %.4f s with %u bytes.\n",
+           c->capacity, c->execution_time, c->memory_required);
+    knapsack_context_free(c);
+    return solved;
+}
+
+/* Two items of half a unit fill a knapsack of one, not two */
+static bool test_report_weights()
+{
+    knapsack_context* c = knapsack_context_new(1, 2);
+    if(c == NULL) {
+        return false;
+    }
+    item_new(c->items[0], "A", 1, 0.5, 1);
+    item_new(c->items[1], "B", 1, 0.5, 1);
+    c->scale = 100;
+    c->unit = "kg";
+    if(!knapsack(c) || !knapsack_report(c)) {
+        knapsack_context_free(c);
+        return false;
+    }
+    knapsack_context_free(c);
+
+    FILE* report = fopen("reports/knapsack.tex", "r");
+    if(report == NULL) {
+        return false;
+    }
+    char line[256];
+    bool found = false;
+    while(!found && (fgets(line, sizeof(line), report) != NULL)) {
+        found = strstr(line, "Total accumulated weight : {\\Large 1/1}") !=
+                NULL;
+    }
+    fclose(report);
+    return found;
+}
+
+/* Check fixed point weights against the same instance in whole units, and
+ * rows reduced by the common divisor against searching */
+static bool test_fixed(int trials)
+{
+    int scales[] = {1, 4, 100};
+
+    for(int t = 0; t < trials; t++) {
+        int scale = scales[t % 3];
+        int capacity = 1 + rand() % 200;
+        int num_items = 1 + rand() % 10;
+
+        knapsack_context* fixed = knapsack_context_new(capacity, num_items);
+        knapsack_context* whole = knapsack_context_new(capacity * scale,
+                                                       num_items);
+        if((fixed == NULL) || (whole == NULL)) {
+            return false;
+        }
+        int multiple = 1 + rand() % 5;
+        for(int j = 0; j < num_items; j++) {
+            int units = multiple * (1 + rand() % (20 * scale));
+            float value = rand() % 20;
+            float amount = 1 + rand() % 10;
+            item_new(fixed->items[j], "X", value, (float)units / scale,
+                     amount);
+            item_new(whole->items[j], "X", value, units, amount);
+        }
+        fixed->scale = scale;
+
+        if(!knapsack(fixed) || !knapsack(whole)) {
+            return false;
+        }
+        bool same = (fixed->total_value == whole->total_value) &&
+                    (memcmp(fixed->solution, whole->solution,
+                            num_items * sizeof(int)) == 0) &&
+                    valid_solution(fixed) &&
+                    (fixed->divisor > 0) &&
+                    (fixed->divisor % multiple == 0) &&
+                    (fixed->table_values->rows ==
+                     knapsack_row(fixed, capacity) + 1);
+        knapsack_context_free(fixed);
+        knapsack_context_free(whole);
+
+        if(!same) {
+            printf("Fixed point weights differ on trial %i.\n", t);
+            return false;
+        }
+    }
+
+    /* Weights 250, 500, 750... */
+    knapsack_context* c = knapsack_context_new(1000000, 20);
+    knapsack_context* search = knapsack_context_new_compact(1000000, 20);
+    if((c == NULL) || (search == NULL)) {
+        return false;
+    }
+    for(int j = 0; j < c->num_items; j++) {
+        item_new(c->items[j], "X", 1 + rand() % 1000,
+                 250 * (1 + rand() % 400), 1 + rand() % 5);
+        *search->items[j] = *c->items[j];
+    }
+    bool exact = knapsack(c) && knapsack(search) &&
+                 (c->table_values->rows == 1000000 / 250 + 1) &&
+                 (c->total_value == search->total_value) &&
+                 valid_solution(c);
+    printf("Weights multiple of 250 in %i rows, %.4f s.\n",
+           c->table_values->rows, c->execution_time);
+    knapsack_context_free(c);
+    knapsack_context_free(search);
+    return exact;
+}
+
+/* Best value putting one item of each group [g, groups), trying them all */
+static float brute_groups(knapsack_context* c, int g, int groups, int left)
+{
+    if(g == groups) {
+        return 0.0;
+    }
+    float best = MINUS_INF;
+    for(int j = 0; j < c->num_items; j++) {
+        item* it = c->items[j];
+        if((it->group != g) || (it->weight > left)) {
+            continue;
+        }
+        float rest = brute_groups(c, g + 1, groups, left - (int)it->weight);
+        if((rest != MINUS_INF) && (rest + it->value > best)) {
+            best = rest + it->value;
+        }
+    }
+    return best;
+}
+
+/* Check one item per group against trying every choice, in threads too */
+static bool test_groups(int trials)
+{
+    for(int t = 0; t < trials; t++) {
+        int capacity = 1 + rand() % 100;
+        int num_items = 1 + rand() % 15;
+        int groups = 1 + rand() % 4;
+
+        knapsack_context* c = knapsack_context_new_compact(capacity,
+                                                           num_items);
+        knapsack_context* p = knapsack_context_new_compact(capacity,
+                                                           num_items);
+        if((c == NULL) || (p == NULL)) {
+            return false;
+        }
+        for(int j = 0; j < num_items; j++) {
+            item_new(c->items[j], "X", rand() % 20, rand() % 30, 1);
+            c->items[j]->group = (j < groups) ? j : rand() % groups;
+            *p->items[j] = *c->items[j];
+        }
+        p->threads = 3;
+
+        float best = brute_groups(c, 0, (groups < num_items) ?
+                                        groups : num_items, capacity);
+        bool solved = knapsack_groups(c);
+        bool same = (solved == (best != MINUS_INF)) &&
+                    (knapsack_groups(p) == solved);
+        if(same && solved) {
+            int picked = 0;
+            for(int j = 0; j < num_items; j++) {
+                picked += c->solution[j];
+            }
+            same = (c->total_value == best) && valid_solution(c) &&
+                   (picked == ((groups < num_items) ? groups : num_items)) &&
+                   (memcmp(c->solution, p->solution,
+                           num_items * sizeof(int)) == 0);
+        }
+        knapsack_context_free(c);
+        knapsack_context_free(p);
+
+        if(!same) {
+            printf("Groups differ on trial %i.\n", t);
+            return false;
+        }
+    }
+    return true;
+}
+
 int main(int argc, char **argv)
 {
     printf("Testing Knapsack algorithm...\n\n");
@@ -54,7 +904,7 @@ int main(int argc, char **argv)
     printf("-----------------------------------\n");
     matrix_print(c->table_values);
     printf("-----------------------------------\n");
-    matrix_print(c->table_items);
+    knapsack_decisions_print(c->table_items);
 
     /* Generate report */
     bool report_created = knapsack_report(c);
@@ -74,5 +924,101 @@ int main(int argc, char **argv)
 
     /* Free resources */
     knapsack_context_free(c);
+
+    /* Check large amounts */
+    if(!test_bounded(300)) {
+        printf("ERROR: Bounded tables test failed.\n");
+        return(-3);
+    }
+    printf("Bounded, unbounded and subset sum tables match.\n");
+
+    /* Check threads */
+    if(!test_threads(200)) {
+        printf("ERROR: Threads test failed.\n");
+        return(-3);
+    }
+    printf("Threaded tables are identical to the serial ones.\n");
+    bench_threads(20000, 100);
+
+    /* Check vectorized kernel */
+    if(!bench_shifts(20000, 100)) {
+        printf("ERROR: Shifted columns differ from the scalar loop.\n");
+        return(-3);
+    }
+
+    /* Check approximation */
+    if(!test_fptas(200)) {
+        printf("ERROR: Approximation test failed.\n");
+        return(-3);
+    }
+    printf("Approximations are within their error.\n");
+
+    /* Check capacity queries */
+    if(!test_queries(50)) {
+        printf("ERROR: Capacity queries test failed.\n");
+        return(-3);
+    }
+    printf("Capacity queries match solving again.\n");
+
+    /* Check appending and removing items */
+    if(!test_incremental(100)) {
+        printf("ERROR: Incremental test failed.\n");
+        return(-3);
+    }
+    printf("Appended and removed items match solving again.\n");
+
+    /* Check frontier engine */
+    if(!test_pareto(300)) {
+        printf("ERROR: Frontier engine test failed.\n");
+        return(-3);
+    }
+    printf("Frontier engine matches the tables.\n");
+
+    /* Check several constraints */
+    if(!test_multi(200)) {
+        printf("ERROR: Several constraints test failed.\n");
+        return(-3);
+    }
+    printf("Several constraints match brute force.\n");
+
+    /* Check O(capacity) memory engine */
+    if(!test_rolling(500)) {
+        printf("ERROR: Rolling engine test failed.\n");
+        return(-3);
+    }
+    if(!test_rolling_weightless()) {
+        printf("ERROR: Rolling engine weightless items test failed.\n");
+        return(-3);
+    }
+    printf("Rolling engine matches the tables.\n");
+
+    /* Check branch and bound */
+    if(!test_branch(300)) {
+        printf("ERROR: Branch and bound test failed.\n");
+        return(-3);
+    }
+    printf("Branch and bound matches the tables.\n");
+
+    /* Check fixed point weights */
+    if(!test_fixed(200)) {
+        printf("ERROR: Fixed point test failed.\n");
+        return(-3);
+    }
+    printf("Fixed point weights match whole ones.\n");
+
+    /* Check the report adds fixed point weights exactly */
+    if(!test_report_weights()) {
+        printf("ERROR: Report weights test failed.\n");
+        return(-3);
+    }
+    printf("Report adds fixed point weights exactly.\n");
+
+    /* Check one item per group */
+    if(!test_groups(300)) {
+        printf("ERROR: Groups test failed.\n");
+        return(-3);
+    }
+    printf("One item per group matches brute force.\n");
+
     return(0);
 }
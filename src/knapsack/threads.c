@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "threads.h"
+#include "kernels.h"
+#include <pthread.h>
+
+/**
+ * Data of each worker thread.
+ */
+typedef struct {
+    knapsack_context* c;
+    knapsack_kind* kinds;
+    pthread_barrier_t* barrier;
+    int* deque;
+    float* scratch;
+    int rank;
+    int threads;
+} knapsack_worker;
+
+static gpointer knapsack_work(gpointer data)
+{
+    knapsack_worker* w = (knapsack_worker*) data;
+    knapsack_context* c = w->c;
+    int rows = c->table_values->rows;
+    int chunks = (rows + KNAPSACK_CHUNK - 1) / KNAPSACK_CHUNK;
+
+    for(int j = 0; j < c->num_items; j++) {
+
+        if((w->kinds[j] == KNAPSACK_ANY) ||
+           (w->kinds[j] == KNAPSACK_SHIFTS)) {
+            /* Range of chunks of rows */
+            int from = (chunks * w->rank / w->threads) * KNAPSACK_CHUNK;
+            int to = (chunks * (w->rank + 1) / w->threads) * KNAPSACK_CHUNK;
+            if(to > rows) {
+                to = rows;
+            }
+            if(w->kinds[j] == KNAPSACK_SHIFTS) {
+                knapsack_shifts(c, j, w->scratch, from, to);
+            } else {
+                knapsack_rows(c, w->kinds, j, j + 1, from, to);
+            }
+        } else {
+            /* Range of residues */
+            int weight = (int)c->items[j]->weight;
+            int residues = (weight < rows) ? weight : rows;
+            knapsack_residues(c, j, w->deque,
+                              residues * w->rank / w->threads,
+                              residues * (w->rank + 1) / w->threads);
+        }
+
+        /* Next item needs the whole column */
+        pthread_barrier_wait(w->barrier);
+    }
+    return NULL;
+}
+
+/* Floats in a cache line, each thread's scratch starts on its own line */
+#define KNAPSACK_LINE 16
+
+bool knapsack_threads(knapsack_context* c, int threads)
+{
+    int rows = c->table_values->rows;
+    int chunks = (rows + KNAPSACK_CHUNK - 1) / KNAPSACK_CHUNK;
+    knapsack_kind* kinds = (knapsack_kind*) malloc(
+                                    c->num_items * sizeof(knapsack_kind));
+    knapsack_worker* workers = (knapsack_worker*) malloc(
+                                    threads * sizeof(knapsack_worker));
+    GThread** handles = (GThread**) malloc(threads * sizeof(GThread*));
+    size_t* scratch_sizes = (size_t*) calloc(threads, sizeof(size_t));
+    size_t* deque_sizes = (size_t*) calloc(threads, sizeof(size_t));
+    if((kinds == NULL) || (workers == NULL) || (handles == NULL) ||
+       (scratch_sizes == NULL) || (deque_sizes == NULL)) {
+        free(kinds);
+        free(workers);
+        free(handles);
+        free(scratch_sizes);
+        free(deque_sizes);
+        return false;
+    }
+
+    /* Scratch for each thread's own rows and residues only */
+    for(int j = 0; j < c->num_items; j++) {
+        kinds[j] = knapsack_kind_of(c, c->items[j]);
+        int weight = (int)c->items[j]->weight;
+        int residues = (weight < rows) ? weight : rows;
+        for(int t = 0; t < threads; t++) {
+            size_t need = 0;
+            if(kinds[j] == KNAPSACK_SHIFTS) {
+                int from = (chunks * t / threads) * KNAPSACK_CHUNK;
+                int to = (chunks * (t + 1) / threads) * KNAPSACK_CHUNK;
+                if(to > rows) {
+                    to = rows;
+                }
+                need = (to > from) ? knapsack_shifts_scratch(c, to - from) : 0;
+                if(need > scratch_sizes[t]) {
+                    scratch_sizes[t] = need;
+                }
+            } else if((kinds[j] == KNAPSACK_BOUNDED) &&
+                      (residues * (t + 1) / threads >
+                       residues * t / threads)) {
+                need = knapsack_residues_deque(c, weight);
+                if(need > deque_sizes[t]) {
+                    deque_sizes[t] = need;
+                }
+            }
+        }
+    }
+
+    /* One block, each thread's part rounded up to whole cache lines */
+    size_t total = 0;
+    for(int t = 0; t < threads; t++) {
+        size_t deque = (deque_sizes[t] * sizeof(int) + sizeof(float) - 1) /
+                       sizeof(float);
+        total += (scratch_sizes[t] + deque + KNAPSACK_LINE - 1) /
+                 KNAPSACK_LINE * KNAPSACK_LINE;
+    }
+    void* block = NULL;
+    if((total > 0) &&
+       (posix_memalign(&block, KNAPSACK_LINE * sizeof(float),
+                       total * sizeof(float)) != 0)) {
+        free(kinds);
+        free(workers);
+        free(handles);
+        free(scratch_sizes);
+        free(deque_sizes);
+        return false;
+    }
+
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, threads);
+    float* next = (float*) block;
+    for(int t = 0; t < threads; t++) {
+        size_t deque = (deque_sizes[t] * sizeof(int) + sizeof(float) - 1) /
+                       sizeof(float);
+        workers[t].c = c;
+        workers[t].kinds = kinds;
+        workers[t].barrier = &barrier;
+        workers[t].scratch = next;
+        workers[t].deque = (int*) (next + scratch_sizes[t]);
+        workers[t].rank = t;
+        workers[t].threads = threads;
+        if(next != NULL) {
+            next += (scratch_sizes[t] + deque + KNAPSACK_LINE - 1) /
+                    KNAPSACK_LINE * KNAPSACK_LINE;
+        }
+    }
+
+    /* Spawn workers, this thread is the first one */
+    for(int t = 1; t < threads; t++) {
+        handles[t] = g_thread_new("knapsack", knapsack_work, &workers[t]);
+    }
+    knapsack_work(&workers[0]);
+    for(int t = 1; t < threads; t++) {
+        g_thread_join(handles[t]);
+    }
+
+    pthread_barrier_destroy(&barrier);
+    free(kinds);
+    free(workers);
+    free(handles);
+    free(scratch_sizes);
+    free(deque_sizes);
+    free(block);
+    return true;
+}
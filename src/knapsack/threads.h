@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_KNAPSACK_THREADS
+#define H_KNAPSACK_THREADS
+
+#include "knapsack.h"
+
+/*
+ * Rows the capacities are split in. Each row of 'table_values' is its own
+ * allocation and each row of 'table_items' its own 64 bit words, so threads
+ * on different rows never write the same decision word and share a cache
+ * line of values at most where their ranges meet. Whole chunks just keep the
+ * ranges from being finer than worth a thread.
+ */
+#define KNAPSACK_CHUNK 16
+
+/**
+ * Perform Knapsack algorithm with several threads.
+ *
+ * Each item's column only depends on the previous one, so it is split between
+ * the threads, which wait for each other on a barrier before the next item.
+ * Columns whose cells only read the previous column are split in ranges of
+ * KNAPSACK_CHUNK rows. Bounded and unbounded columns are split by residue
+ * modulo the weight, as rows one weight apart depend on each other. Each
+ * thread only gets scratch for its own range of rows or residues. Every cell
+ * is computed by the same kernel as in the serial knapsack(), so the tables
+ * are bit-identical.
+ *
+ * @param knapsack_context, the knapsack's context data structure.
+ * @param threads, the total number of threads, the calling one included.
+ * @return TRUE if execution was successful or FALSE if and error ocurred.
+ */
+bool knapsack_threads(knapsack_context* c, int threads);
+
+#endif
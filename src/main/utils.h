@@ -32,6 +32,13 @@
 
 #define F_EPSILON 0.000001
 
+/* Compile hot loops for several instruction sets, picked at load time */
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#define SIMD_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define SIMD_CLONES
+#endif
+
 bool file_exists(char *fname);
 char* read_file(char* fname);
 
@@ -0,0 +1,376 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "bracket.h"
+#include <stdint.h>
+
+/**
+ * Data of each worker thread.
+ */
+typedef struct {
+    probwin_bracket_context* c;
+    int from;
+    int to;
+    bool success;
+} probwin_bracket_worker;
+
+probwin_bracket_context* probwin_bracket_context_new(int teams)
+{
+    /* Check input is correct */
+    if((teams < 2) || ((teams & (teams - 1)) != 0)) {
+        return NULL;
+    }
+    int rounds = 0;
+    while((1 << rounds) < teams) {
+        rounds++;
+    }
+
+    /* Allocate structure */
+    probwin_bracket_context* c = (probwin_bracket_context*) calloc(1,
+                                            sizeof(probwin_bracket_context));
+    if(c == NULL) {
+        return NULL;
+    }
+    c->teams = teams;
+    c->rounds = rounds;
+    c->threads = 1;
+
+    c->seeds = (int*) malloc(teams * sizeof(int));
+    c->home = matrix_new(teams, teams, 0.5);
+    c->road = matrix_new(teams, teams, 0.5);
+    c->games = (int*) calloc(rounds, sizeof(int));
+    c->game_format = (bool**) calloc(rounds, sizeof(bool*));
+    c->reach = matrix_new(teams, rounds + 1, 0.0);
+    c->title = (float*) malloc(teams * sizeof(float));
+    c->cache = (GHashTable**) calloc(rounds, sizeof(GHashTable*));
+    if((c->seeds == NULL) || (c->home == NULL) || (c->road == NULL) ||
+       (c->games == NULL) || (c->game_format == NULL) ||
+       (c->reach == NULL) || (c->title == NULL) || (c->cache == NULL)) {
+        probwin_bracket_context_free(c);
+        return NULL;
+    }
+
+    for(int t = 0; t < teams; t++) {
+        c->seeds[t] = t;
+    }
+    for(int r = 0; r < rounds; r++) {
+        c->cache[r] = g_hash_table_new_full(g_int64_hash, g_int64_equal,
+                                            free, NULL);
+    }
+    return c;
+}
+
+void probwin_bracket_context_free(probwin_bracket_context* c)
+{
+    for(int r = 0; r < c->rounds; r++) {
+        if(c->game_format != NULL) {
+            free(c->game_format[r]);
+        }
+        if((c->cache != NULL) && (c->cache[r] != NULL)) {
+            g_hash_table_destroy(c->cache[r]);
+        }
+    }
+    if(c->home != NULL) {
+        matrix_free(c->home);
+    }
+    if(c->road != NULL) {
+        matrix_free(c->road);
+    }
+    if(c->reach != NULL) {
+        matrix_free(c->reach);
+    }
+    free(c->seeds);
+    free(c->games);
+    free(c->game_format);
+    free(c->title);
+    free(c->cache);
+    free(c->series);
+    free(c);
+    return;
+}
+
+bool probwin_bracket_set_round(probwin_bracket_context* c, int round,
+                               int games, bool* format)
+{
+    if((round < 0) || (round >= c->rounds) || (games < 1) ||
+       (games % 2 == 0)) {
+        return false;
+    }
+    bool* copy = (bool*) malloc(games * sizeof(bool));
+    if(copy == NULL) {
+        return false;
+    }
+    memcpy(copy, format, games * sizeof(bool));
+    free(c->game_format[round]);
+    c->game_format[round] = copy;
+    c->games[round] = games;
+
+    /* Solved series may have used the old format */
+    for(int r = 0; r < c->rounds; r++) {
+        g_hash_table_remove_all(c->cache[r]);
+    }
+    c->series_used = 0;
+    return true;
+}
+
+/* Cache key of a series, the bits of its two probabilities */
+static gint64 probwin_bracket_key(float ph, float pr)
+{
+    uint32_t home;
+    uint32_t road;
+    memcpy(&home, &ph, sizeof(float));
+    memcpy(&road, &pr, sizeof(float));
+    return ((gint64)home << 32) | road;
+}
+
+/* Series of a round, queued to be solved if not in the cache */
+static int probwin_bracket_lookup(probwin_bracket_context* c, int round,
+                                  float ph, float pr)
+{
+    gint64 key = probwin_bracket_key(ph, pr);
+
+    gpointer found = g_hash_table_lookup(c->cache[round], &key);
+    if(found != NULL) {
+        return GPOINTER_TO_INT(found) - 1;
+    }
+
+    /* New series, solved later */
+    if(c->series_used == c->series_size) {
+        int size = (c->series_size > 0) ? 2 * c->series_size : 64;
+        probwin_series* larger = (probwin_series*) realloc(c->series,
+                                            size * sizeof(probwin_series));
+        if(larger == NULL) {
+            return -1;
+        }
+        c->series = larger;
+        c->series_size = size;
+    }
+    gint64* stored = (gint64*) malloc(sizeof(gint64));
+    if(stored == NULL) {
+        return -1;
+    }
+    *stored = key;
+
+    int s = c->series_used++;
+    c->series[s].round = round;
+    c->series[s].ph = ph;
+    c->series[s].pr = pr;
+    c->series[s].champion = 0.0;
+    g_hash_table_insert(c->cache[round], stored, GINT_TO_POINTER(s + 1));
+    return s;
+}
+
+/* Drop the series queued since 'first', they were never solved */
+static void probwin_bracket_forget(probwin_bracket_context* c, int first)
+{
+    for(int s = first; s < c->series_used; s++) {
+        probwin_series* series = &c->series[s];
+        gint64 key = probwin_bracket_key(series->ph, series->pr);
+        g_hash_table_remove(c->cache[series->round], &key);
+    }
+    c->series_used = first;
+}
+
+static gpointer probwin_bracket_work(gpointer data)
+{
+    probwin_bracket_worker* w = (probwin_bracket_worker*) data;
+    probwin_bracket_context* c = w->c;
+    probwin_context* k = NULL;
+    int round = -1;
+
+    w->success = true;
+    for(int s = w->from; s < w->to; s++) {
+        probwin_series* series = &c->series[s];
+
+        /* Series come round by round, one context for each */
+        if(series->round != round) {
+            if(k != NULL) {
+                probwin_context_free(k);
+            }
+            round = series->round;
+            k = probwin_context_new_compact(c->games[round]);
+            if(k == NULL) {
+                w->success = false;
+                return NULL;
+            }
+            memcpy(k->game_format, c->game_format[round],
+                   c->games[round] * sizeof(bool));
+        }
+
+        k->ph = series->ph;
+        k->pr = series->pr;
+        if(!probwin(k)) {
+            w->success = false;
+            break;
+        }
+        series->champion = k->champion;
+    }
+
+    if(k != NULL) {
+        probwin_context_free(k);
+    }
+    return NULL;
+}
+
+/* Solve series 'from' to 'to' in 'threads' threads */
+static bool probwin_bracket_solve(probwin_bracket_context* c, int from,
+                                  int to)
+{
+    int threads = (c->threads > 1) ? c->threads : 1;
+    if(threads > to - from) {
+        threads = (to - from > 1) ? to - from : 1;
+    }
+    probwin_bracket_worker* workers = (probwin_bracket_worker*) malloc(
+                                    threads * sizeof(probwin_bracket_worker));
+    GThread** handles = (GThread**) malloc(threads * sizeof(GThread*));
+    if((workers == NULL) || (handles == NULL)) {
+        free(workers);
+        free(handles);
+        return false;
+    }
+
+    for(int t = 0; t < threads; t++) {
+        workers[t].c = c;
+        workers[t].from = from + (int)((long)(to - from) * t / threads);
+        workers[t].to = from + (int)((long)(to - from) * (t + 1) / threads);
+    }
+
+    /* Spawn workers, this thread is the first one */
+    for(int t = 1; t < threads; t++) {
+        handles[t] = g_thread_new("probwin", probwin_bracket_work,
+                                  &workers[t]);
+    }
+    probwin_bracket_work(&workers[0]);
+    bool success = workers[0].success;
+    for(int t = 1; t < threads; t++) {
+        g_thread_join(handles[t]);
+        success = success && workers[t].success;
+    }
+
+    free(workers);
+    free(handles);
+    return success;
+}
+
+bool probwin_bracket(probwin_bracket_context* c)
+{
+    /* Rounds with the same format share their series */
+    int* same = (int*) malloc(c->rounds * sizeof(int));
+    int* pairs = (int*) malloc((size_t)c->teams * (c->teams - 1) / 2 *
+                               sizeof(int));
+    if((same == NULL) || (pairs == NULL)) {
+        free(same);
+        free(pairs);
+        return false;
+    }
+    for(int r = 0; r < c->rounds; r++) {
+        if(c->games[r] == 0) {
+            free(same);
+            free(pairs);
+            return false;
+        }
+        same[r] = r;
+        for(int q = 0; q < r; q++) {
+            if((c->games[q] == c->games[r]) &&
+               (memcmp(c->game_format[q], c->game_format[r],
+                       c->games[r] * sizeof(bool)) == 0)) {
+                same[r] = q;
+                break;
+            }
+        }
+    }
+
+    /* Start counting time */
+    GTimer* timer = g_timer_new();
+
+    /* Series of every pair that can meet, new ones queued to be solved */
+    int first = c->series_used;
+    int used = 0;
+    for(int r = 0; r < c->rounds; r++) {
+        int half = 1 << r;
+        for(int block = 0; block < c->teams; block += 2 * half) {
+            for(int t = block; t < block + half; t++) {
+                for(int o = block + half; o < block + 2 * half; o++) {
+                    int a = (c->seeds[t] <= c->seeds[o]) ? t : o;
+                    int b = (a == t) ? o : t;
+                    int s = probwin_bracket_lookup(c, same[r],
+                                                   c->home->data[a][b],
+                                                   c->road->data[a][b]);
+                    if(s < 0) {
+                        probwin_bracket_forget(c, first);
+                        free(same);
+                        free(pairs);
+                        g_timer_destroy(timer);
+                        return false;
+                    }
+                    pairs[used++] = s;
+                }
+            }
+        }
+    }
+    c->solved = c->series_used - first;
+    c->cached = used - c->solved;
+
+    if((c->solved > 0) &&
+       !probwin_bracket_solve(c, first, c->series_used)) {
+        probwin_bracket_forget(c, first);
+        free(same);
+        free(pairs);
+        g_timer_destroy(timer);
+        return false;
+    }
+
+    /* Combine the rounds, in the same order the pairs were listed */
+    matrix* reach = c->reach;
+    for(int t = 0; t < c->teams; t++) {
+        reach->data[t][0] = 1.0;
+        for(int r = 1; r <= c->rounds; r++) {
+            reach->data[t][r] = 0.0;
+        }
+    }
+    used = 0;
+    for(int r = 0; r < c->rounds; r++) {
+        int half = 1 << r;
+        for(int block = 0; block < c->teams; block += 2 * half) {
+            for(int t = block; t < block + half; t++) {
+                for(int o = block + half; o < block + 2 * half; o++) {
+                    float wins = c->series[pairs[used++]].champion;
+                    if(c->seeds[t] > c->seeds[o]) {
+                        wins = 1.0 - wins;
+                    }
+                    float meet = reach->data[t][r] * reach->data[o][r];
+                    reach->data[t][r + 1] += meet * wins;
+                    reach->data[o][r + 1] += meet * (1.0 - wins);
+                }
+            }
+        }
+    }
+    for(int t = 0; t < c->teams; t++) {
+        c->title[t] = reach->data[t][c->rounds];
+    }
+
+    free(same);
+    free(pairs);
+
+    /* Stop counting time */
+    g_timer_stop(timer);
+    c->execution_time = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+    return true;
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef H_PROBWIN_BRACKET
+#define H_PROBWIN_BRACKET
+
+#include "probwin.h"
+
+/**
+ * A series solved for a bracket, its A being the better seeded team.
+ */
+typedef struct {
+    int round;
+    float ph;
+    float pr;
+    float champion;
+} probwin_series;
+
+/**
+ * Knockout bracket of series, teams numbered in bracket order: team 2k plays
+ * team 2k + 1 in the first round, the winners of teams 0 to 3 meet in the
+ * second one and so on.
+ */
+typedef struct {
+
+    /* Common */
+    double execution_time;
+    int threads;
+
+    /* Teams, a power of two, and their seeds, lower is better */
+    int teams;
+    int rounds;
+    int* seeds;
+
+    /* Probability of the row's team beating the column's one at home and on
+     * the road, only read with the better seeded team as the row */
+    matrix* home;
+    matrix* road;
+
+    /* Series format of each round, TRUE if the better seed plays at home */
+    int* games;
+    bool** game_format;
+
+    /* Probability of each team winning its first r rounds, at column r */
+    matrix* reach;
+
+    /* Probability of each team winning the bracket, the last column */
+    float* title;
+
+    /* Solved series, kept between calls while the formats don't change */
+    probwin_series* series;
+    int series_size;
+    int series_used;
+    GHashTable** cache;
+
+    /* Series solved and matchups found in the cache by the last call */
+    int solved;
+    int cached;
+
+} probwin_bracket_context;
+
+/**
+ * Create a bracket context, seeds set to the team numbers and every round's
+ * format left to be set with probwin_bracket_set_round().
+ *
+ * @param teams, the number of teams, a power of two of at least 2.
+ * @return a new bracket context or NULL if the number of teams is wrong or
+ *         memory ran out.
+ */
+probwin_bracket_context* probwin_bracket_context_new(int teams);
+void probwin_bracket_context_free(probwin_bracket_context* c);
+
+/**
+ * Set the series format of a round, clearing the solved series.
+ *
+ * @param round, the round, 0 being the first one.
+ * @param games, the number of games of its series, must be odd.
+ * @param format, TRUE for each game the better seed plays at home.
+ * @return FALSE if the round or number of games is wrong or memory ran out.
+ */
+bool probwin_bracket_set_round(probwin_bracket_context* c, int round,
+                               int games, bool* format);
+
+/**
+ * Compute every team's probability of reaching each round and of winning the
+ * bracket.
+ *
+ * Every pair of teams that can meet is a series, with the better seed as A
+ * and the probabilities of its row in 'home' and 'road'. Series are cached
+ * by their probabilities and round format, so rounds with the same format
+ * share them, and only those not seen yet are solved, in compact contexts
+ * split between 'threads' threads. The rounds are then combined a team at a
+ * time: a team reaches the next round if it wins against whoever comes out
+ * of the other half of its block.
+ *
+ * @param probwin_bracket_context, the bracket's context data structure.
+ * @return TRUE if execution was successful or FALSE if a round has no format
+ *         or memory ran out.
+ */
+bool probwin_bracket(probwin_bracket_context* c);
+
+#endif
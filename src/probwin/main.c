@@ -21,6 +21,11 @@
 #include "dialogs.h"
 #include <gtk/gtk.h>
 
+/* Series played to check the result, fewer for long series so no more
+ * than SIMULATED_GAMES games are played in total, well under a second */
+#define SIMULATIONS 1000000
+#define SIMULATED_GAMES 20000000
+
 /* GUI */
 GtkWindow* window;
 
@@ -49,6 +54,9 @@ void games_changed(int g);
 void games_changed_cb(GtkSpinButton* spinbutton, gpointer user_data);
 void cell_edited_cb(GtkCellRendererToggle *cell_renderer,
                     gchar* path, gpointer user_data);
+void probability_edited_cb(GtkCellRendererText* renderer, gchar* path,
+                           gchar* new_text, gpointer user_data);
+void reset_probabilities();
 void process(GtkButton* button, gpointer user_data);
 
 void save_cb(GtkButton* button, gpointer user_data);
@@ -101,6 +109,19 @@ int main(int argc, char **argv)
     gtk_file_chooser_add_filter(load_dialog, file_filter);
     gtk_file_chooser_add_filter(save_dialog, file_filter);
 
+    /* Configure cell renderers callback */
+    GtkCellRenderer* win_renderer = GTK_CELL_RENDERER(
+                            gtk_builder_get_object(builder, "win_renderer"));
+    g_signal_connect(G_OBJECT(win_renderer),
+                         "edited", G_CALLBACK(probability_edited_cb),
+                         GINT_TO_POINTER(2));
+
+    GtkCellRenderer* draw_renderer = GTK_CELL_RENDERER(
+                            gtk_builder_get_object(builder, "draw_renderer"));
+    g_signal_connect(G_OBJECT(draw_renderer),
+                         "edited", G_CALLBACK(probability_edited_cb),
+                         GINT_TO_POINTER(3));
+
     /* Connect signals */
     gtk_builder_connect_signals(builder, NULL);
 
@@ -120,6 +141,30 @@ void prob_changed_cb(GtkSpinButton* spinbutton, gpointer user_data)
     } else {
         gtk_label_set_text(prob_b_home, g_strdup_printf("%.4f", complement));
     }
+    reset_probabilities();
+}
+
+void reset_probabilities()
+{
+    /* Every game back to the home or road probability */
+    GtkTreeIter iter;
+    bool was_set = gtk_tree_model_get_iter_first(
+                            GTK_TREE_MODEL(format_model), &iter);
+    while(was_set) {
+        GValue value = G_VALUE_INIT;
+        gtk_tree_model_get_value(
+                            GTK_TREE_MODEL(format_model), &iter, 1, &value);
+        bool at_home = g_value_get_boolean(&value);
+        g_value_unset(&value);
+
+        GtkSpinButton* prob = at_home ? prob_a_home : prob_a_road;
+        gtk_list_store_set(format_model, &iter,
+                        2, (gfloat)gtk_spin_button_get_value(prob),
+                        -1);
+
+        was_set = gtk_tree_model_iter_next(
+                            GTK_TREE_MODEL(format_model), &iter);
+    }
 }
 
 void games_changed(int g)
@@ -134,9 +179,12 @@ void games_changed(int g)
     bool swap = true;
     for(int i = 0; i < g; i++) {
         gtk_list_store_append(format_model, &iter);
+        GtkSpinButton* prob = swap ? prob_a_home : prob_a_road;
         gtk_list_store_set(format_model, &iter,
                         0, i + 1,
                         1, swap,
+                        2, (gfloat)gtk_spin_button_get_value(prob),
+                        3, 0.0f,
                         -1);
         swap = !swap;
     }
@@ -171,10 +219,38 @@ void cell_edited_cb(GtkCellRendererToggle *cell_renderer,
 
     GValue value = G_VALUE_INIT;
 
+    bool at_home = !gtk_cell_renderer_toggle_get_active(cell_renderer);
     g_value_init(&value, G_TYPE_BOOLEAN);
-    g_value_set_boolean(&value,
-                        !gtk_cell_renderer_toggle_get_active(cell_renderer));
+    g_value_set_boolean(&value, at_home);
     gtk_list_store_set_value(format_model, &iter, 1, &value);
+
+    /* The game takes the probability of where it is played */
+    GtkSpinButton* prob = at_home ? prob_a_home : prob_a_road;
+    gtk_list_store_set(format_model, &iter,
+                    2, (gfloat)gtk_spin_button_get_value(prob),
+                    -1);
+}
+
+void probability_edited_cb(GtkCellRendererText* renderer, gchar* path,
+                           gchar* new_text, gpointer user_data)
+{
+    int column = GPOINTER_TO_INT(user_data);
+
+    /* Get reference to model */
+    GtkTreePath* model_path = gtk_tree_path_new_from_string(path);
+    GtkTreeIter iter;
+    gtk_tree_model_get_iter(GTK_TREE_MODEL(format_model), &iter, model_path);
+    gtk_tree_path_free(model_path);
+
+    /* Probability, draws can't be certain */
+    char* end;
+    double p = strtod(new_text, &end);
+    if((end == new_text) || (*end != '\0') || (p < 0.0) || (p > 1.0) ||
+       ((column == 3) && (p == 1.0))) {
+        show_error(window, "Probabilities must be between 0 and 1.");
+        return;
+    }
+    gtk_list_store_set(format_model, &iter, column, (gfloat)p, -1);
 }
 
 void process(GtkButton* button, gpointer user_data)
@@ -213,6 +289,15 @@ void process(GtkButton* button, gpointer user_data)
 
     GValue value = G_VALUE_INIT;
     bool* f = c->game_format;
+    float* wins = (float*) malloc(g * sizeof(float));
+    float* draws = (float*) malloc(g * sizeof(float));
+    if((wins == NULL) || (draws == NULL)) {
+        free(wins);
+        free(draws);
+        show_error(window, "Unable to allocate enough memory for "
+                           "this problem. Sorry.");
+        return;
+    }
 
     int i = 0;
     do {
@@ -221,6 +306,16 @@ void process(GtkButton* button, gpointer user_data)
         bool w = g_value_get_boolean(&value);
         g_value_unset(&value);
 
+        gtk_tree_model_get_value(
+                            GTK_TREE_MODEL(format_model), &iter, 2, &value);
+        wins[i] = g_value_get_float(&value);
+        g_value_unset(&value);
+
+        gtk_tree_model_get_value(
+                            GTK_TREE_MODEL(format_model), &iter, 3, &value);
+        draws[i] = g_value_get_float(&value);
+        g_value_unset(&value);
+
         /* Set values */
         f[i] = w;
 
@@ -229,6 +324,16 @@ void process(GtkButton* button, gpointer user_data)
         i++;
     } while(was_set);
 
+    /* Per game probabilities */
+    bool valid = probwin_set_games(c, wins, draws);
+    free(wins);
+    free(draws);
+    if(!valid) {
+        show_error(window, "A game can't be won or drawn with a probability "
+                           "above 1. Please check your data.");
+        return;
+    }
+
     /* Execute algorithm */
     bool success = probwin(c);
     if(!success) {
@@ -236,6 +341,15 @@ void process(GtkButton* button, gpointer user_data)
                            "Please check your data.");
     }
 
+    /* Cross-check by playing the series, shown in the report */
+    if(success) {
+        long series = SIMULATED_GAMES / g;
+        if(series > SIMULATIONS) {
+            series = SIMULATIONS;
+        }
+        probwin_simulate(c, series, g_get_num_processors(), 0);
+    }
+
     /* Generate report */
     bool report_created = probwin_report(c);
     if(!report_created) {
@@ -358,6 +472,7 @@ void save(FILE* file)
 
     fprintf( file, "%i\n", gtk_spin_button_get_value_as_int(num_games));
 
+    /* One game per line: at home, probability of A winning and of a draw */
     GtkTreeIter iter;
     GValue value = G_VALUE_INIT;
     bool was_set = gtk_tree_model_get_iter_first(
@@ -368,10 +483,20 @@ void save(FILE* file)
         bool w = g_value_get_boolean(&value);
         g_value_unset(&value);
 
+        gtk_tree_model_get_value(
+                            GTK_TREE_MODEL(format_model), &iter, 2, &value);
+        float win = g_value_get_float(&value);
+        g_value_unset(&value);
+
+        gtk_tree_model_get_value(
+                            GTK_TREE_MODEL(format_model), &iter, 3, &value);
+        float draw = g_value_get_float(&value);
+        g_value_unset(&value);
+
         was_set = gtk_tree_model_iter_next(
                             GTK_TREE_MODEL(format_model), &iter);
 
-        fprintf(file, "%i\n", w);
+        fprintf(file, "%i %1.4f %1.4f\n", w, win, draw);
     }
 
 }
@@ -407,12 +532,24 @@ void load(FILE* file)
 
     for(int i = 0; (i < n_games) && has_row; i++) {
 
-        /* Get values */
+        /* Get values, older files only tell where the game is played */
         int at_home = 0;
-        fscanf(file, "%d%*c", &at_home);
+        char* line = get_line(file);
+        if(line == NULL) {
+            break;
+        }
+        float win = -1.0;
+        float draw = 0.0;
+        sscanf(line, "%d %f %f", &at_home, &win, &draw);
+        free(line);
+        if(win < 0.0) {
+            GtkSpinButton* prob = at_home ? prob_a_home : prob_a_road;
+            win = gtk_spin_button_get_value(prob);
+        }
 
         /* Set values */
-        gtk_list_store_set(format_model, &iter, 0, i + 1, 1, (bool)at_home, -1);
+        gtk_list_store_set(format_model, &iter, 0, i + 1, 1, (bool)at_home,
+                           2, win, 3, draw, -1);
 
         /* Next */
         has_row = gtk_tree_model_iter_next(GTK_TREE_MODEL(format_model), &iter);
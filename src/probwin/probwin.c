@@ -18,7 +18,7 @@
 
 #include "probwin.h"
 
-probwin_context* probwin_context_new(int games)
+static probwin_context* probwin_context_alloc(int games, bool tables)
 {
     /* Check input is correct */
     if(games % 2 == 0) {
@@ -44,28 +44,43 @@ probwin_context* probwin_context_new(int games)
 
     /* Try to allocate matrices */
     int size = games_to_win + 1;
-    c->table_w = matrix_new(size, size, 0.0);
-    if(c->table_w == NULL) {
-        free(c->game_format);
-        free(c);
-        return NULL;
-    }
+    c->table_w = NULL;
+    if(tables) {
+        c->table_w = matrix_new(size, size, 0.0);
+        if(c->table_w == NULL) {
+            free(c->game_format);
+            free(c);
+            return NULL;
+        }
 
-    /* Initialize values */
-    c->table_w->data[0][0] = PLUS_INF;
-    for(int i = 1; i <= games_to_win; i++) {
-        c->table_w->data[0][i] = 1.0;
+        /* Initialize values */
+        c->table_w->data[0][0] = PLUS_INF;
+        for(int i = 1; i <= games_to_win; i++) {
+            c->table_w->data[0][i] = 1.0;
+        }
     }
     c->a_name = "";
     c->b_name = "";
 
     c->status = -1;
     c->execution_time = 0;
-    c->memory_required = matrix_sizeof(c->table_w) + (games * sizeof(bool)) +
-                         sizeof(probwin_context);
+    c->memory_required = (games * sizeof(bool)) +
+                         (2 * size * sizeof(float)) + sizeof(probwin_context);
+    if(tables) {
+        c->memory_required += matrix_sizeof(c->table_w);
+    }
+    c->champion = 0.0;
+    c->simulations = 0;
+    c->simulated = 0.0;
+    c->simulated_error = 0.0;
+    c->simulation_time = 0;
+    c->game_win = NULL;
+    c->game_draw = NULL;
     c->report_buffer = tmpfile();
     if(c->report_buffer == NULL) {
-        matrix_free(c->table_w);
+        if(tables) {
+            matrix_free(c->table_w);
+        }
         free(c->game_format);
         free(c);
         return NULL;
@@ -74,39 +89,169 @@ probwin_context* probwin_context_new(int games)
     return c;
 }
 
+probwin_context* probwin_context_new(int games)
+{
+    return probwin_context_alloc(games, true);
+}
+
+probwin_context* probwin_context_new_compact(int games)
+{
+    return probwin_context_alloc(games, false);
+}
+
 void probwin_context_free(probwin_context* c)
 {
-    matrix_free(c->table_w);
+    if(c->table_w != NULL) {
+        matrix_free(c->table_w);
+    }
     fclose(c->report_buffer);
     free(c->game_format);
+    free(c->game_win);
+    free(c->game_draw);
     free(c);
     return;
 }
 
+bool probwin_set_games(probwin_context* c, float* wins, float* draws)
+{
+    for(int g = 0; g < c->games; g++) {
+        float draw = (draws != NULL) ? draws[g] : 0.0;
+        if((wins[g] < 0.0) || (draw < 0.0) || (draw >= 1.0) ||
+           (wins[g] + draw > 1.0)) {
+            return false;
+        }
+    }
+
+    /* Allocated on first use, draws only if there are any. Both are
+     * allocated before either is published, so a failure leaves the
+     * context as it was */
+    float* win = c->game_win;
+    float* draw = c->game_draw;
+    if(win == NULL) {
+        win = (float*) malloc(c->games * sizeof(float));
+    }
+    if((draws != NULL) && (draw == NULL)) {
+        draw = (float*) malloc(c->games * sizeof(float));
+    }
+    if((win == NULL) || ((draws != NULL) && (draw == NULL))) {
+        if(win != c->game_win) {
+            free(win);
+        }
+        if(draw != c->game_draw) {
+            free(draw);
+        }
+        return false;
+    }
+    if(win != c->game_win) {
+        c->game_win = win;
+        c->memory_required += c->games * sizeof(float);
+    }
+    if(draw != c->game_draw) {
+        c->game_draw = draw;
+        c->memory_required += c->games * sizeof(float);
+    }
+
+    memcpy(c->game_win, wins, c->games * sizeof(float));
+    for(int g = 0; (g < c->games) && (c->game_draw != NULL); g++) {
+        c->game_draw[g] = (draws != NULL) ? draws[g] : 0.0;
+    }
+    return true;
+}
+
+float probwin_game(probwin_context* c, int game)
+{
+    if(c->game_win == NULL) {
+        return c->game_format[game] ? c->ph : c->pr;
+    }
+
+    /* A drawn game is played again, with the same probabilities */
+    if(c->game_draw != NULL) {
+        return c->game_win[game] / (1.0 - c->game_draw[game]);
+    }
+    return c->game_win[game];
+}
+
+/*
+ * Cells (i, j) with the same i + j are the same game of the series, so they
+ * share its probability and only need the previous anti-diagonal. Stored by
+ * i, the up neighbour of cell i is cell i - 1 of the previous diagonal and
+ * the left one is cell i, so a diagonal is a vector operation.
+ */
+SIMD_CLONES
+static void probwin_diagonal(float p, const float* restrict previous,
+                             float* restrict next, int from, int to)
+{
+    float q = 1.0 - p;
+    for(int i = from; i < to; i++) {
+        next[i] = p * previous[i - 1] + q * previous[i];
+    }
+}
+
 bool probwin(probwin_context *c)
 {
     /* Start counting time */
     GTimer* timer = g_timer_new();
 
-    /* Run the probabilities to win algorithm */
+    /* Strips of rows, the whole table if there is none to read back */
     matrix* w = c->table_w;
-    int games = c->games;
-    float p;
+    int n = (c->games + 1) / 2;
+    int strip = (w != NULL) ? PROBWIN_STRIP : n;
+
+    /* Two anti-diagonals of a strip, skewed so each one is contiguous. Cell
+     * k is row first + k - 1, cell 0 being the last row of the strip above */
+    float* diagonals = (float*) malloc(2 * (strip + 1) * sizeof(float));
+    if(diagonals == NULL) {
+        g_timer_destroy(timer);
+        return false;
+    }
+    float* previous = diagonals;
+    float* next = diagonals + strip + 1;
+
+    /* Run the probabilities to win algorithm, a strip at a time */
+    for(int first = 1; first <= n; first += strip) {
+        int last = (first + strip - 1 < n) ? first + strip - 1 : n;
+
+        /* Then a game at a time */
+        for(int d = first + 1; d <= last + n; d++) {
 
-    for(int i = 1; i < w->rows; i++) {
-        for(int j = 1; j < w->columns; j++) {
+            /* Cell above the strip, A already won in row 0 */
+            if(d - first <= n) {
+                previous[0] = 1.0;
+                if(first > 1) {
+                    previous[0] = w->data[first - 1][d - first];
+                }
+            }
+
+            /* Cell left of the strip, B already won */
+            if(d - 1 <= last) {
+                previous[d - first] = 0.0;
+            }
 
             /* Decide which probability to use */
-            int current_game = games + 1 - i - j;
-            p = c->pr;
-            if(c->game_format[current_game]) {
-                p = c->ph;
+            float p = probwin_game(c, c->games + 1 - d);
+
+            int from = (d - n > first) ? d - n : first;
+            int to = (d - 1 < last) ? d : last + 1;
+            probwin_diagonal(p, previous, next, from - first + 1,
+                             to - first + 1);
+
+            /* Cells of the strip are in a few rows, kept in cache */
+            if(w != NULL) {
+                for(int i = from; i < to; i++) {
+                    w->data[i][d - i] = next[i - first + 1];
+                }
             }
 
-            w->data[i][j] = p * w->data[i - 1][j] +
-                            (1.0 - p) * w->data[i][j - 1];
+            float* swap = previous;
+            previous = next;
+            next = swap;
+        }
+
+        if(last == n) {
+            c->champion = previous[n - first + 1];
         }
     }
+    free(diagonals);
 
     /* Stop counting time */
     g_timer_stop(timer);
@@ -114,3 +259,26 @@ bool probwin(probwin_context *c)
     g_timer_destroy(timer);
     return true;
 }
+
+bool probwin_states(probwin_context* c, int a_needs, float* row)
+{
+    int n = (c->games + 1) / 2;
+    if((a_needs < 0) || (a_needs > n)) {
+        return false;
+    }
+
+    /* Row 0, A already won */
+    row[0] = (a_needs == 0) ? PLUS_INF : 0.0;
+    for(int j = 1; j <= n; j++) {
+        row[j] = 1.0;
+    }
+
+    /* Each row overwrites the previous one left to right */
+    for(int i = 1; i <= a_needs; i++) {
+        for(int j = 1; j <= n; j++) {
+            float p = probwin_game(c, c->games + 1 - i - j);
+            row[j] = p * row[j] + (1.0f - p) * row[j - 1];
+        }
+    }
+    return true;
+}
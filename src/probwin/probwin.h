@@ -22,6 +22,9 @@
 #include "utils.h"
 #include "matrix.h"
 
+/* Rows filled together, their cells of a diagonal stay in cache */
+#define PROBWIN_STRIP 64
+
 /**
  * Probabilities to become champion algorithm context data structure.
  */
@@ -33,9 +36,18 @@ typedef struct{
     unsigned int memory_required;
     FILE* report_buffer;
 
-    /* Tables */
+    /* Tables, NULL if created with probwin_context_new_compact() */
     matrix* table_w;
 
+    /* Probability of A winning the series, W[n][n] */
+    float champion;
+
+    /* Estimate of 'champion' by probwin_simulate(), if any series played */
+    long simulations;
+    float simulated;
+    float simulated_error;
+    double simulation_time;
+
     /* Probabilities */
     float ph;
     float pr;
@@ -44,6 +56,10 @@ typedef struct{
     int games;
     bool* game_format;
 
+    /* Per game probabilities, NULL unless set by probwin_set_games() */
+    float* game_win;
+    float* game_draw;
+
     /* Report */
     char* a_name;
     char* b_name;
@@ -53,9 +69,44 @@ typedef struct{
 probwin_context* probwin_context_new(int games);
 void probwin_context_free(probwin_context* c);
 
+/**
+ * Create a context without table, probwin() then only keeps two
+ * anti-diagonals and fills 'champion', see probwin_states() for the
+ * probabilities at other states.
+ */
+probwin_context* probwin_context_new_compact(int games);
+
+/**
+ * Give every game its own probabilities instead of 'ph' and 'pr'.
+ *
+ * A drawn game is played again with the same probabilities, so a draw only
+ * scales the odds of its game and the table keeps its size.
+ *
+ * @param wins, the probability of A winning each game.
+ * @param draws, the probability of each game being a draw, or NULL if there
+ *        are no draws.
+ * @return FALSE if a probability is out of range, a game is always a draw or
+ *         memory ran out.
+ */
+bool probwin_set_games(probwin_context* c, float* wins, float* draws);
+
+/**
+ * Probability of A winning a game once it is decided, from 'ph' and 'pr' or
+ * from the probabilities set by probwin_set_games().
+ *
+ * @param game, the game, from 0 to games - 1.
+ */
+float probwin_game(probwin_context* c, int game);
+
 /**
  * Perform Probabilities to become champion algorithm with given context.
  *
+ * Every cell of an anti-diagonal is the same game of the series, so each one
+ * is a single vector operation over the previous diagonal. The table is
+ * filled in strips of PROBWIN_STRIP rows, diagonal by diagonal inside each,
+ * so the rows being written stay in cache. Without table the whole series is
+ * one strip of two diagonals, the last one giving 'champion' either way.
+ *
  * @param probwin_context, the Probabilities to become champion's context data
  *        structure.
  * @return TRUE if execution was successful or FALSE if and error ocurred. Check
@@ -63,6 +114,22 @@ void probwin_context_free(probwin_context* c);
  */
 bool probwin(probwin_context* c);
 
+/**
+ * Probabilities of A winning the series from the states where A still needs
+ * 'a_needs' wins, in O(games) memory. A single row is rolled over itself.
+ *
+ * @param probwin_context, the Probabilities to become champion's context data
+ *        structure, a compact one is enough.
+ * @param a_needs, the wins A still needs, between 0 and (games + 1) / 2.
+ * @param row, filled with (games + 1) / 2 + 1 values, value j being the
+ *        probability when B still needs j wins.
+ * @return FALSE if 'a_needs' is out of range.
+ */
+bool probwin_states(probwin_context* c, int a_needs, float* row);
+
 #include "report.h"
+#include "sweep.h"
+#include "simulate.h"
+#include "bracket.h"
 
 #endif
@@ -20,6 +20,11 @@
 
 bool probwin_report(probwin_context* c)
 {
+    /* Compact contexts have no table to show */
+    if(c->table_w == NULL) {
+        return false;
+    }
+
     /* Create report file */
     FILE* report = fopen("reports/probwin.tex", "w");
     if(report == NULL) {
@@ -103,13 +108,20 @@ bool probwin_report(probwin_context* c)
 
 
     /* Write digest */
-    float prob = c->table_w->data[(c->games + 1) / 2][(c->games + 1) / 2];
+    float prob = c->champion;
     fprintf(report, "\\subsection{%s}\n", "Digest");
     fprintf(report, "At the beginning of the series, {\\Large %s} has a "
                     "probability to win of {\\Large %0.4f}, and therefore "
                     "{\\Large %s} has a probability of {\\Large %0.4f}",
                     c->a_name, prob, c->b_name, 1 - prob);
     fprintf(report, "\n");
+    if(c->simulations > 0) {
+        fprintf(report, "\n\\noindent{}Playing the series %li times "
+                        "in %lf seconds, {\\Large %s} won {\\Large %0.4f} "
+                        "$\\pm$ %0.4f of them.\n",
+                        c->simulations, c->simulation_time, c->a_name,
+                        c->simulated, c->simulated_error);
+    }
 
     /* End document */
     fprintf(report, "\\end{document}\n");
@@ -131,27 +143,34 @@ bool probwin_report(probwin_context* c)
 
 void probwin_format(probwin_context* c, FILE* stream)
 {
-    /* Game number  A plays at home */
+    /* Game number  A plays at home  [A wins  Draw] */
+    bool per_game = (c->game_win != NULL);
 
     /* Table preamble */
     fprintf(stream, "\\begin{table}[!ht]\n");
     fprintf(stream, "\\centering\n");
-    fprintf(stream, "\\begin{tabular}{|c|c|}\n");
+    fprintf(stream, "\\begin{tabular}{|c|c%s|}\n", per_game ? "|c|c" : "");
     fprintf(stream, "\\hline\n");
 
     /* Table headers */
     fprintf(stream, "\\cellcolor{gray90}\\textbf{%s} &"
                     "\\cellcolor{gray90}\\textbf{%s %s}",
                     "Game number", c->a_name, "plays at home");
+    if(per_game) {
+        fprintf(stream, " & \\cellcolor{gray90}\\textbf{%s %s} &"
+                        "\\cellcolor{gray90}\\textbf{%s}",
+                        c->a_name, "wins", "Draw");
+    }
     fprintf(stream, " \\\\ \n\\hline\\hline\n");
 
     /* Table body */
     for(int i = 0; i < c->games; i++) {
-        if(c->game_format[i]) {
-            fprintf(stream, "%i & %s \\\\ \\hline\n", i + 1, "Yes");
-        } else {
-            fprintf(stream, "%i & %s \\\\ \\hline\n", i + 1, "No");
+        fprintf(stream, "%i & %s", i + 1, c->game_format[i] ? "Yes" : "No");
+        if(per_game) {
+            float draw = (c->game_draw != NULL) ? c->game_draw[i] : 0.0;
+            fprintf(stream, " & %1.4f & %1.4f", c->game_win[i], draw);
         }
+        fprintf(stream, " \\\\ \\hline\n");
     }
     fprintf(stream, "\\end{tabular}\n");
 
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "simulate.h"
+
+/* Random numbers are compared to the probabilities in 32 bits */
+#define PROBWIN_ONE 4294967296.0
+
+/**
+ * Data of each worker thread.
+ */
+typedef struct {
+    probwin_context* c;
+    uint64_t* wins;
+    uint64_t* draws;
+    uint64_t seed;
+    long from;
+    long to;
+    long won;
+} probwin_simulator;
+
+/* SplitMix64 finalizer, a counter based generator */
+static inline uint64_t probwin_mix(uint64_t x)
+{
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+static gpointer probwin_simulate_work(gpointer data)
+{
+    probwin_simulator* s = (probwin_simulator*) data;
+    int n = (s->c->games + 1) / 2;
+    long won = 0;
+
+    for(long k = s->from; k < s->to; k++) {
+        uint64_t key = probwin_mix(s->seed + 0x9e3779b97f4a7c15ULL * k);
+        uint64_t counter = 0;
+        int a = 0;
+        int b = 0;
+        int game = 0;
+        while((a < n) && (b < n)) {
+            uint64_t u = probwin_mix(key + counter++) >> 32;
+            if(u < s->wins[game]) {
+                a++;
+            } else if(u >= s->draws[game]) {
+                b++;
+            } else {
+                /* Drawn, play the game again */
+                continue;
+            }
+            game++;
+        }
+        won += (a == n);
+    }
+
+    s->won = won;
+    return NULL;
+}
+
+bool probwin_simulate(probwin_context* c, long series, int threads,
+                      uint64_t seed)
+{
+    if(series < 1) {
+        return false;
+    }
+    if(threads < 1) {
+        threads = 1;
+    }
+
+    /* Start counting time */
+    GTimer* timer = g_timer_new();
+
+    /* A wins below the first threshold, draws below the second */
+    uint64_t* wins = (uint64_t*) malloc(2 * c->games * sizeof(uint64_t));
+    probwin_simulator* workers = (probwin_simulator*) malloc(
+                                    threads * sizeof(probwin_simulator));
+    GThread** handles = (GThread**) malloc(threads * sizeof(GThread*));
+    if((wins == NULL) || (workers == NULL) || (handles == NULL)) {
+        free(wins);
+        free(workers);
+        free(handles);
+        g_timer_destroy(timer);
+        return false;
+    }
+    uint64_t* draws = wins + c->games;
+    for(int g = 0; g < c->games; g++) {
+        double win = c->game_format[g] ? c->ph : c->pr;
+        double draw = 0.0;
+        if(c->game_win != NULL) {
+            win = c->game_win[g];
+            draw = (c->game_draw != NULL) ? c->game_draw[g] : 0.0;
+        }
+        wins[g] = (uint64_t)(win * PROBWIN_ONE);
+        draws[g] = (uint64_t)((win + draw) * PROBWIN_ONE);
+    }
+
+    for(int t = 0; t < threads; t++) {
+        workers[t].c = c;
+        workers[t].wins = wins;
+        workers[t].draws = draws;
+        workers[t].seed = seed;
+        workers[t].from = series * t / threads;
+        workers[t].to = series * (t + 1) / threads;
+        workers[t].won = 0;
+    }
+
+    /* Spawn workers, this thread is the first one */
+    for(int t = 1; t < threads; t++) {
+        handles[t] = g_thread_new("probwin", probwin_simulate_work,
+                                  &workers[t]);
+    }
+    probwin_simulate_work(&workers[0]);
+    long won = workers[0].won;
+    for(int t = 1; t < threads; t++) {
+        g_thread_join(handles[t]);
+        won += workers[t].won;
+    }
+
+    double p = (double)won / series;
+    c->simulations = series;
+    c->simulated = p;
+    c->simulated_error = 1.96 * sqrt(p * (1.0 - p) / series);
+
+    free(wins);
+    free(workers);
+    free(handles);
+
+    /* Stop counting time */
+    g_timer_stop(timer);
+    c->simulation_time = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+    return true;
+}
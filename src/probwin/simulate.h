@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef H_PROBWIN_SIMULATE
+#define H_PROBWIN_SIMULATE
+
+#include "probwin.h"
+#include <stdint.h>
+
+/**
+ * Play the series of a context many times to estimate the probability of A
+ * winning it, as a check of probwin().
+ *
+ * Each game is won, lost or drawn with the context's probabilities, a drawn
+ * game being played again. The random numbers of every series come from a
+ * hash of the seed, the series number and a counter, so the estimate is the
+ * same whatever the number of threads. Series are split between 'threads'
+ * threads.
+ *
+ * Fills 'simulations', 'simulated' and 'simulated_error', the half width of
+ * the 95% confidence interval, which the report shows next to the exact
+ * probability.
+ *
+ * @param probwin_context, the Probabilities to become champion's context data
+ *        structure, a compact one is enough.
+ * @param series, the number of series to play.
+ * @param threads, the total number of threads, the calling one included.
+ * @param seed, the seed of the random numbers.
+ * @return TRUE if execution was successful or FALSE if memory ran out or
+ *         there are no series to play.
+ */
+bool probwin_simulate(probwin_context* c, long series, int threads,
+                      uint64_t seed);
+
+#endif
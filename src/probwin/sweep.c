@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sweep.h"
+
+/**
+ * Data of each worker thread.
+ */
+typedef struct {
+    probwin_sweep_context* s;
+    float* rows;
+    int rank;
+    int threads;
+} probwin_sweep_worker;
+
+probwin_sweep_context* probwin_sweep_context_new(int games, int points)
+{
+    /* Check input is correct */
+    if((games % 2 == 0) || (points < 1)) {
+        return NULL;
+    }
+
+    /* Allocate structure */
+    probwin_sweep_context* s = (probwin_sweep_context*) malloc(
+                                            sizeof(probwin_sweep_context));
+    if(s == NULL) {
+        return NULL;
+    }
+    s->ph = (float*) malloc(points * sizeof(float));
+    s->pr = (float*) malloc(points * sizeof(float));
+    s->results = (float*) malloc(points * sizeof(float));
+    s->game_format = (bool*) malloc(games * sizeof(bool));
+    if((s->ph == NULL) || (s->pr == NULL) || (s->results == NULL) ||
+       (s->game_format == NULL)) {
+        probwin_sweep_context_free(s);
+        return NULL;
+    }
+
+    s->execution_time = 0;
+    s->threads = 1;
+    s->points = points;
+    s->games = games;
+    return s;
+}
+
+void probwin_sweep_context_free(probwin_sweep_context* s)
+{
+    free(s->ph);
+    free(s->pr);
+    free(s->results);
+    free(s->game_format);
+    free(s);
+    return;
+}
+
+/* A cell of every point in a block, from the cell above and the left one */
+SIMD_CLONES
+static void probwin_lanes(const float* restrict p,
+                          const float* restrict left,
+                          float* restrict cell, int lanes)
+{
+    for(int k = 0; k < lanes; k++) {
+        cell[k] = p[k] * cell[k] + (1.0f - p[k]) * left[k];
+    }
+}
+
+static void probwin_block(probwin_sweep_context* s, float* rows, int first)
+{
+    int n = (s->games + 1) / 2;
+    int lanes = s->points - first;
+    if(lanes > PROBWIN_LANES) {
+        lanes = PROBWIN_LANES;
+    }
+
+    /* Row 0, A already won, and column 0, B already won */
+    for(int k = 0; k < lanes; k++) {
+        rows[k] = 0.0;
+    }
+    for(int j = 1; j <= n; j++) {
+        for(int k = 0; k < lanes; k++) {
+            rows[j * PROBWIN_LANES + k] = 1.0;
+        }
+    }
+
+    /* Each row overwrites the previous one left to right */
+    for(int i = 1; i <= n; i++) {
+        for(int j = 1; j <= n; j++) {
+            int current_game = s->games + 1 - i - j;
+            const float* p = s->game_format[current_game] ?
+                             s->ph + first : s->pr + first;
+            probwin_lanes(p, rows + (j - 1) * PROBWIN_LANES,
+                          rows + j * PROBWIN_LANES, lanes);
+        }
+    }
+
+    for(int k = 0; k < lanes; k++) {
+        s->results[first + k] = rows[n * PROBWIN_LANES + k];
+    }
+}
+
+static gpointer probwin_sweep_work(gpointer data)
+{
+    probwin_sweep_worker* w = (probwin_sweep_worker*) data;
+    int blocks = (w->s->points + PROBWIN_LANES - 1) / PROBWIN_LANES;
+    int from = blocks * w->rank / w->threads;
+    int to = blocks * (w->rank + 1) / w->threads;
+
+    for(int b = from; b < to; b++) {
+        probwin_block(w->s, w->rows, b * PROBWIN_LANES);
+    }
+    return NULL;
+}
+
+bool probwin_sweep(probwin_sweep_context* s)
+{
+    /* Start counting time */
+    GTimer* timer = g_timer_new();
+
+    int blocks = (s->points + PROBWIN_LANES - 1) / PROBWIN_LANES;
+    int threads = (s->threads > 1) ? s->threads : 1;
+    if(threads > blocks) {
+        threads = blocks;
+    }
+    size_t block = (size_t)((s->games + 1) / 2 + 1) * PROBWIN_LANES;
+
+    probwin_sweep_worker* workers = (probwin_sweep_worker*) malloc(
+                                    threads * sizeof(probwin_sweep_worker));
+    GThread** handles = (GThread**) malloc(threads * sizeof(GThread*));
+    float* rows = (float*) malloc(threads * block * sizeof(float));
+    if((workers == NULL) || (handles == NULL) || (rows == NULL)) {
+        free(workers);
+        free(handles);
+        free(rows);
+        g_timer_destroy(timer);
+        return false;
+    }
+
+    for(int t = 0; t < threads; t++) {
+        workers[t].s = s;
+        workers[t].rows = rows + (t * block);
+        workers[t].rank = t;
+        workers[t].threads = threads;
+    }
+
+    /* Spawn workers, this thread is the first one */
+    for(int t = 1; t < threads; t++) {
+        handles[t] = g_thread_new("probwin", probwin_sweep_work, &workers[t]);
+    }
+    probwin_sweep_work(&workers[0]);
+    for(int t = 1; t < threads; t++) {
+        g_thread_join(handles[t]);
+    }
+
+    free(workers);
+    free(handles);
+    free(rows);
+
+    /* Stop counting time */
+    g_timer_stop(timer);
+    s->execution_time = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+    return true;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef H_PROBWIN_SWEEP
+#define H_PROBWIN_SWEEP
+
+#include "probwin.h"
+
+/* Points swept together, a multiple of the widest vector */
+#define PROBWIN_LANES 64
+
+/**
+ * Probabilities to become champion over many pairs of probabilities, all
+ * sharing one game format.
+ */
+typedef struct {
+
+    /* Common */
+    double execution_time;
+    int threads;
+
+    /* Points, one pair of probabilities each */
+    int points;
+    float* ph;
+    float* pr;
+
+    /* Probability of A winning the series at each point */
+    float* results;
+
+    /* Game format */
+    int games;
+    bool* game_format;
+
+} probwin_sweep_context;
+
+/**
+ * Create a sweep context, its probabilities and game format left to be set.
+ *
+ * @param games, the number of games of the series, must be odd.
+ * @param points, the number of pairs of probabilities.
+ * @return a new sweep context or NULL if games is even, there are no points
+ *         or memory ran out.
+ */
+probwin_sweep_context* probwin_sweep_context_new(int games, int points);
+void probwin_sweep_context_free(probwin_sweep_context* s);
+
+/**
+ * Perform Probabilities to become champion algorithm at every point.
+ *
+ * Points are taken PROBWIN_LANES at a time, each block keeping one row of the
+ * table per point, stored so that a cell of every point is contiguous. A
+ * cell of the whole block is then a single vector operation. Blocks are split
+ * between 'threads' threads and only the last cell of each point is kept.
+ *
+ * @param probwin_sweep_context, the sweep's context data structure.
+ * @return TRUE if execution was successful or FALSE if memory ran out.
+ */
+bool probwin_sweep(probwin_sweep_context* s);
+
+#endif
@@ -19,6 +19,565 @@
 #include "probwin.h"
 #include "latex.h"
 
+/* The table filled row by row, one cell at a time */
+static void probwin_rows(probwin_context* c, matrix* w)
+{
+    for(int i = 1; i < w->rows; i++) {
+        for(int j = 1; j < w->columns; j++) {
+            int current_game = c->games + 1 - i - j;
+            float p = c->game_format[current_game] ? c->ph : c->pr;
+            w->data[i][j] = p * w->data[i - 1][j] +
+                            (1.0 - p) * w->data[i][j - 1];
+        }
+    }
+}
+
+static probwin_context* random_series(int games)
+{
+    probwin_context* c = probwin_context_new(games);
+    if(c == NULL) {
+        return NULL;
+    }
+    for(int g = 0; g < games; g++) {
+        c->game_format[g] = rand() % 2;
+    }
+    c->ph = (rand() % 1001) / 1000.0;
+    c->pr = (rand() % 1001) / 1000.0;
+    return c;
+}
+
+static bool test_diagonals(int trials)
+{
+    for(int t = 0; t < trials; t++) {
+        probwin_context* c = random_series(1 + 2 * (rand() % 150));
+        if(c == NULL) {
+            return false;
+        }
+        int size = c->table_w->rows;
+        matrix* w = matrix_new(size, size, 0.0);
+        if((w == NULL) || !probwin(c)) {
+            return false;
+        }
+        matrix_copy(c->table_w, w);
+        for(int i = 1; i < size; i++) {
+            for(int j = 1; j < size; j++) {
+                w->data[i][j] = 0.0;
+            }
+        }
+        probwin_rows(c, w);
+
+        bool same = true;
+        for(int i = 0; i < size; i++) {
+            for(int j = 0; j < size; j++) {
+                if(fabs(w->data[i][j] - c->table_w->data[i][j]) > 1e-5) {
+                    same = false;
+                }
+            }
+        }
+        matrix_free(w);
+        probwin_context_free(c);
+
+        if(!same) {
+            printf("Diagonals differ on trial %i.\n", t);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Sum of the cells filled in a table, to compare tables too large to copy */
+static double table_sum(matrix* w)
+{
+    double sum = 0.0;
+    for(int i = 1; i < w->rows; i++) {
+        for(int j = 1; j < w->columns; j++) {
+            sum += w->data[i][j];
+        }
+    }
+    return sum;
+}
+
+/* Time the diagonals against the rows, only their tables must match */
+static bool bench_diagonals(int games)
+{
+    probwin_context* c = random_series(games);
+    if(c == NULL) {
+        return false;
+    }
+    c->ph = 0.6;
+    c->pr = 0.45;
+
+    /* Best of a few runs of each, on the same table */
+    double diagonals = PLUS_INF;
+    double rows = PLUS_INF;
+    bool same = true;
+    for(int run = 0; run < 3; run++) {
+        if(!probwin(c)) {
+            probwin_context_free(c);
+            return false;
+        }
+        if(c->execution_time < diagonals) {
+            diagonals = c->execution_time;
+        }
+        double sum = table_sum(c->table_w);
+        float champion = c->champion;
+
+        GTimer* timer = g_timer_new();
+        probwin_rows(c, c->table_w);
+        g_timer_stop(timer);
+        if(g_timer_elapsed(timer, NULL) < rows) {
+            rows = g_timer_elapsed(timer, NULL);
+        }
+        g_timer_destroy(timer);
+
+        /* Long series add up more rounding than test_diagonals() allows */
+        int n = c->table_w->rows - 1;
+        same = same &&
+               (fabs(table_sum(c->table_w) - sum) <= 1e-4 * fabs(sum)) &&
+               (fabs(c->table_w->data[n][n] - champion) <= 1e-4);
+    }
+    printf("%i games: %.4f s by diagonals, %.4f s by rows, %.2fx\n", games,
+           diagonals, rows, rows / diagonals);
+
+    probwin_context* k = probwin_context_new_compact(games);
+    if(k != NULL) {
+        memcpy(k->game_format, c->game_format, games * sizeof(bool));
+        k->ph = c->ph;
+        k->pr = c->pr;
+        probwin(k);
+        printf("%i games: %.4f s without table\n", games, k->execution_time);
+        probwin_context_free(k);
+    }
+    probwin_context_free(c);
+    return same;
+}
+
+static bool test_compact(int trials)
+{
+    for(int t = 0; t < trials; t++) {
+        int games = 1 + 2 * (rand() % 100);
+        probwin_context* c = random_series(games);
+        probwin_context* k = probwin_context_new_compact(games);
+        int n = (games + 1) / 2;
+        float* row = (float*) malloc((n + 1) * sizeof(float));
+        if((c == NULL) || (k == NULL) || (row == NULL)) {
+            return false;
+        }
+        memcpy(k->game_format, c->game_format, games * sizeof(bool));
+        k->ph = c->ph;
+        k->pr = c->pr;
+
+        bool same = probwin(c) && probwin(k) &&
+                    (k->table_w == NULL) && (k->champion == c->champion) &&
+                    (c->champion == c->table_w->data[n][n]);
+        for(int i = 0; same && (i <= n); i++) {
+            same = probwin_states(k, i, row);
+            for(int j = 0; same && (j <= n); j++) {
+                if((i == 0) && (j == 0)) {
+                    same = (row[0] == PLUS_INF);
+                } else {
+                    same = fabs(row[j] - c->table_w->data[i][j]) <= 1e-5;
+                }
+            }
+        }
+        same = same && !probwin_states(k, n + 1, row);
+        free(row);
+        probwin_context_free(c);
+        probwin_context_free(k);
+
+        if(!same) {
+            printf("Compact context differs on trial %i.\n", t);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Probability of A winning from a state, a draw playing the game again */
+static double replayed(probwin_context* c, float* wins, float* draws,
+                       int i, int j)
+{
+    if(i == 0) {
+        return 1.0;
+    }
+    if(j == 0) {
+        return 0.0;
+    }
+    int game = c->games + 1 - i - j;
+    double up = replayed(c, wins, draws, i - 1, j);
+    double left = replayed(c, wins, draws, i, j - 1);
+    double loss = 1.0 - wins[game] - draws[game];
+    double x = 0.0;
+    for(int k = 0; k < 100; k++) {
+        x = wins[game] * up + draws[game] * x + loss * left;
+    }
+    return x;
+}
+
+static bool test_games(int trials)
+{
+    for(int t = 0; t < trials; t++) {
+        int games = 1 + 2 * (rand() % 6);
+        probwin_context* c = random_series(games);
+        probwin_context* k = probwin_context_new_compact(games);
+        float* wins = (float*) malloc(games * sizeof(float));
+        float* draws = (float*) malloc(games * sizeof(float));
+        if((c == NULL) || (k == NULL) || (wins == NULL) || (draws == NULL)) {
+            return false;
+        }
+
+        /* Home and road probabilities as per game ones */
+        memcpy(k->game_format, c->game_format, games * sizeof(bool));
+        for(int g = 0; g < games; g++) {
+            wins[g] = c->game_format[g] ? c->ph : c->pr;
+        }
+        bool same = probwin(c) && probwin_set_games(k, wins, NULL) &&
+                    probwin(k) && (k->champion == c->champion);
+
+        /* Draws */
+        for(int g = 0; g < games; g++) {
+            draws[g] = (rand() % 501) / 1000.0;
+            wins[g] = (rand() % 1001) / 1000.0 * (1.0 - draws[g]);
+        }
+        int n = (games + 1) / 2;
+        same = same && probwin_set_games(c, wins, draws) && probwin(c);
+        for(int i = 1; same && (i <= n); i++) {
+            for(int j = 1; same && (j <= n); j++) {
+                same = fabs(c->table_w->data[i][j] -
+                            replayed(c, wins, draws, i, j)) <= 1e-5;
+            }
+        }
+
+        /* Out of range */
+        draws[0] = 1.0;
+        wins[0] = 0.0;
+        same = same && !probwin_set_games(c, wins, draws);
+        draws[0] = 0.5;
+        wins[0] = 0.6;
+        same = same && !probwin_set_games(c, wins, draws);
+
+        free(wins);
+        free(draws);
+        probwin_context_free(c);
+        probwin_context_free(k);
+
+        if(!same) {
+            printf("Per game probabilities differ on trial %i.\n", t);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void bench_games(int games)
+{
+    probwin_context* c = random_series(games);
+    float* wins = (float*) malloc(games * sizeof(float));
+    float* draws = (float*) malloc(games * sizeof(float));
+    if((c != NULL) && (wins != NULL) && (draws != NULL)) {
+        probwin(c);
+        double format = c->execution_time;
+        for(int g = 0; g < games; g++) {
+            draws[g] = 0.1;
+            wins[g] = c->game_format[g] ? 0.5 : 0.4;
+        }
+        if(probwin_set_games(c, wins, draws) && probwin(c)) {
+            printf("%i games: %.4f s home and road, %.4f s per game\n",
+                   games, format, c->execution_time);
+        }
+    }
+    free(wins);
+    free(draws);
+    if(c != NULL) {
+        probwin_context_free(c);
+    }
+}
+
+static bool test_simulate(int trials)
+{
+    for(int t = 0; t < trials; t++) {
+        int games = 1 + 2 * (rand() % 10);
+        probwin_context* c = random_series(games);
+        float* wins = (float*) malloc(games * sizeof(float));
+        float* draws = (float*) malloc(games * sizeof(float));
+        if((c == NULL) || (wins == NULL) || (draws == NULL)) {
+            return false;
+        }
+        if(t % 2 == 1) {
+            for(int g = 0; g < games; g++) {
+                draws[g] = (rand() % 501) / 1000.0;
+                wins[g] = (rand() % 1001) / 1000.0 * (1.0 - draws[g]);
+            }
+            probwin_set_games(c, wins, draws);
+        }
+
+        bool same = probwin(c) && probwin_simulate(c, 100000, 1, t);
+        float simulated = c->simulated;
+        same = same && probwin_simulate(c, 100000, 3, t) &&
+               (c->simulated == simulated) &&
+               (fabs(c->simulated - c->champion) <=
+                2.5 * c->simulated_error + 1e-3);
+
+        free(wins);
+        free(draws);
+        probwin_context_free(c);
+
+        if(!same) {
+            printf("Simulation differs on trial %i.\n", t);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void bench_simulate(int games, long series)
+{
+    probwin_context* c = random_series(games);
+    if(c == NULL) {
+        return;
+    }
+    for(int threads = 1; threads <= 8; threads *= 2) {
+        if(probwin_simulate(c, series, threads, 1)) {
+            printf("%i threads: %.0f series of %i games per second\n",
+                   threads, series / c->simulation_time, games);
+        }
+    }
+    probwin_context_free(c);
+}
+
+/* Series of a bracket played game by game, with a full context */
+static float bracket_series(probwin_bracket_context* b, int round, int t,
+                            int o)
+{
+    int a = (b->seeds[t] <= b->seeds[o]) ? t : o;
+    probwin_context* c = probwin_context_new(b->games[round]);
+    memcpy(c->game_format, b->game_format[round],
+           b->games[round] * sizeof(bool));
+    c->ph = b->home->data[a][(a == t) ? o : t];
+    c->pr = b->road->data[a][(a == t) ? o : t];
+    probwin(c);
+    float wins = c->table_w->data[c->table_w->rows - 1][c->table_w->rows - 1];
+    probwin_context_free(c);
+    return (a == t) ? wins : 1.0 - wins;
+}
+
+/* Title probabilities adding up every outcome of the bracket's series */
+static void brute_bracket(probwin_bracket_context* b, double* title)
+{
+    int series = b->teams - 1;
+    int* alive = (int*) malloc(b->teams * sizeof(int));
+    for(int t = 0; t < b->teams; t++) {
+        title[t] = 0.0;
+    }
+    for(long outcome = 0; outcome < (1L << series); outcome++) {
+        for(int t = 0; t < b->teams; t++) {
+            alive[t] = t;
+        }
+        double p = 1.0;
+        int played = 0;
+        for(int r = 0, left = b->teams; left > 1; r++, left /= 2) {
+            for(int k = 0; k < left / 2; k++) {
+                int t = alive[2 * k];
+                int o = alive[2 * k + 1];
+                float wins = bracket_series(b, r, t, o);
+                if(outcome & (1L << played++)) {
+                    alive[k] = t;
+                    p *= wins;
+                } else {
+                    alive[k] = o;
+                    p *= 1.0 - wins;
+                }
+            }
+        }
+        title[alive[0]] += p;
+    }
+    free(alive);
+}
+
+static probwin_bracket_context* random_bracket(int teams)
+{
+    probwin_bracket_context* b = probwin_bracket_context_new(teams);
+    if(b == NULL) {
+        return NULL;
+    }
+    for(int t = 0; t < teams; t++) {
+        int swap = rand() % (t + 1);
+        b->seeds[t] = b->seeds[swap];
+        b->seeds[swap] = t;
+        for(int o = 0; o < teams; o++) {
+            b->home->data[t][o] = (rand() % 11) / 10.0;
+            b->road->data[t][o] = (rand() % 11) / 10.0;
+        }
+    }
+    for(int r = 0; r < b->rounds; r++) {
+        int games = 1 + 2 * (rand() % 3);
+        bool format[5];
+        for(int g = 0; g < games; g++) {
+            format[g] = rand() % 2;
+        }
+        probwin_bracket_set_round(b, r, games, format);
+    }
+    return b;
+}
+
+static bool test_bracket(int trials)
+{
+    double title[8];
+    for(int t = 0; t < trials; t++) {
+        int teams = 2 << (rand() % 3);
+        probwin_bracket_context* b = random_bracket(teams);
+        if(b == NULL) {
+            return false;
+        }
+        b->threads = 1 + rand() % 4;
+        bool same = probwin_bracket(b);
+
+        double sum = 0.0;
+        brute_bracket(b, title);
+        for(int k = 0; same && (k < teams); k++) {
+            same = fabs(b->title[k] - title[k]) <= 1e-5;
+            sum += b->title[k];
+        }
+        same = same && (fabs(sum - 1.0) <= 1e-5);
+
+        /* Again, all from the cache */
+        float first = b->title[0];
+        same = same && probwin_bracket(b) && (b->solved == 0) &&
+               (b->cached == teams * (teams - 1) / 2) &&
+               (b->title[0] == first);
+        probwin_bracket_context_free(b);
+
+        if(!same) {
+            printf("Bracket differs on trial %i.\n", t);
+            return false;
+        }
+    }
+
+    /* Equal teams and formats are a single series */
+    probwin_bracket_context* b = probwin_bracket_context_new(16);
+    bool format[7] = {true, true, false, false, true, false, true};
+    if(b == NULL) {
+        return false;
+    }
+    for(int r = 0; r < b->rounds; r++) {
+        probwin_bracket_set_round(b, r, 7, format);
+    }
+    bool single = probwin_bracket(b) && (b->solved == 1) &&
+                  (fabs(b->title[5] - 1.0 / 16) <= 1e-5);
+    probwin_bracket_context_free(b);
+    return single;
+}
+
+static void bench_bracket(int teams)
+{
+    probwin_bracket_context* b = probwin_bracket_context_new(teams);
+    bool format[7] = {true, true, false, false, true, false, true};
+    if(b == NULL) {
+        return;
+    }
+
+    /* Strengths, with an edge for the home team */
+    for(int t = 0; t < teams; t++) {
+        for(int o = 0; o < teams; o++) {
+            double st = 1.0 + (teams - t) / (double)teams;
+            double so = 1.0 + (teams - o) / (double)teams;
+            b->home->data[t][o] = 1.1 * st / (1.1 * st + so);
+            b->road->data[t][o] = st / (st + 1.1 * so);
+        }
+    }
+    for(int r = 0; r < b->rounds; r++) {
+        probwin_bracket_set_round(b, r, 7, format);
+    }
+    for(int threads = 1; threads <= 8; threads *= 2) {
+        b->threads = threads;
+        for(int r = 0; r < b->rounds; r++) {
+            probwin_bracket_set_round(b, r, 7, format);
+        }
+        probwin_bracket(b);
+        printf("%i teams, %i threads: %.4f s, %i series solved\n", teams,
+               threads, b->execution_time, b->solved);
+    }
+    probwin_bracket(b);
+    printf("%i teams again: %.4f s, %i series from the cache\n", teams,
+           b->execution_time, b->cached);
+    probwin_bracket_context_free(b);
+}
+
+static bool test_sweep(int trials)
+{
+    for(int t = 0; t < trials; t++) {
+        int games = 1 + 2 * (rand() % 20);
+        int points = 1 + rand() % (3 * PROBWIN_LANES);
+        probwin_sweep_context* s = probwin_sweep_context_new(games, points);
+        probwin_context* c = random_series(games);
+        if((s == NULL) || (c == NULL)) {
+            return false;
+        }
+        memcpy(s->game_format, c->game_format, games * sizeof(bool));
+        s->threads = 1 + rand() % 4;
+        for(int k = 0; k < points; k++) {
+            s->ph[k] = (rand() % 1001) / 1000.0;
+            s->pr[k] = (rand() % 1001) / 1000.0;
+        }
+        if(!probwin_sweep(s)) {
+            return false;
+        }
+
+        bool same = true;
+        int n = (games + 1) / 2;
+        for(int k = 0; k < points; k++) {
+            c->ph = s->ph[k];
+            c->pr = s->pr[k];
+            probwin(c);
+            if(fabs(c->table_w->data[n][n] - s->results[k]) > 1e-5) {
+                same = false;
+            }
+        }
+        probwin_sweep_context_free(s);
+        probwin_context_free(c);
+
+        if(!same) {
+            printf("Sweep differs on trial %i.\n", t);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void bench_sweep(int games, int points)
+{
+    probwin_sweep_context* s = probwin_sweep_context_new(games, points);
+    probwin_context* c = random_series(games);
+    if((s != NULL) && (c != NULL)) {
+        memcpy(s->game_format, c->game_format, games * sizeof(bool));
+        for(int k = 0; k < points; k++) {
+            s->ph[k] = (k % 100) / 100.0;
+            s->pr[k] = (k / 100 % 100) / 100.0;
+        }
+        GTimer* timer = g_timer_new();
+        for(int k = 0; k < points; k++) {
+            c->ph = s->ph[k];
+            c->pr = s->pr[k];
+            probwin(c);
+        }
+        g_timer_stop(timer);
+        printf("%i points of %i games: %.4f s one by one\n", points, games,
+               g_timer_elapsed(timer, NULL));
+        g_timer_destroy(timer);
+        for(int threads = 1; threads <= 8; threads *= 2) {
+            s->threads = threads;
+            probwin_sweep(s);
+            printf("%i threads: %.4f s\n", threads, s->execution_time);
+        }
+    }
+    if(s != NULL) {
+        probwin_sweep_context_free(s);
+    }
+    if(c != NULL) {
+        probwin_context_free(c);
+    }
+}
+
 int main(int argc, char **argv)
 {
     printf("Testing Probabilities to become champion...\n\n");
@@ -60,6 +619,12 @@ int main(int argc, char **argv)
     printf("-----------------------------------\n");
     matrix_print(c->table_w);
 
+    /* Play the series, for the report */
+    if(probwin_simulate(c, 1000000, 4, 42)) {
+        printf("Team A wins with %.4f, played %.4f +- %.4f\n", c->champion,
+               c->simulated, c->simulated_error);
+    }
+
     /* Generate report */
     bool report_created = probwin_report(c);
     if(!report_created) {
@@ -78,5 +643,57 @@ int main(int argc, char **argv)
 
     /* Free resources */
     probwin_context_free(c);
+
+    /* Check vectorized diagonals */
+    if(!test_diagonals(300)) {
+        printf("ERROR: Diagonals test failed.\n");
+        return(-3);
+    }
+    printf("Diagonals match the table filled by rows.\n");
+    if(!bench_diagonals(20001)) {
+        printf("ERROR: Diagonals and rows differ on a long series.\n");
+        return(-3);
+    }
+
+    /* Check compact contexts */
+    if(!test_compact(200)) {
+        printf("ERROR: Compact test failed.\n");
+        return(-3);
+    }
+    printf("Compact contexts match the table.\n");
+
+    /* Check per game probabilities */
+    if(!test_games(200)) {
+        printf("ERROR: Per game probabilities test failed.\n");
+        return(-3);
+    }
+    printf("Per game probabilities and draws match playing draws again.\n");
+    bench_games(20001);
+
+    /* Check simulation */
+    if(!test_simulate(50)) {
+        printf("ERROR: Simulation test failed.\n");
+        return(-3);
+    }
+    printf("Simulations agree with the exact probabilities.\n");
+    bench_simulate(7, 4000000);
+
+    /* Check brackets */
+    if(!test_bracket(100)) {
+        printf("ERROR: Bracket test failed.\n");
+        return(-3);
+    }
+    printf("Brackets match playing every outcome.\n");
+    bench_bracket(64);
+    bench_bracket(128);
+
+    /* Check sweeps */
+    if(!test_sweep(100)) {
+        printf("ERROR: Sweep test failed.\n");
+        return(-3);
+    }
+    printf("Sweeps match one context per point.\n");
+    bench_sweep(101, 10000);
+
     return(0);
 }